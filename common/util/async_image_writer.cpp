@@ -0,0 +1,468 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "async_image_writer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef __SSSE3__
+#  include <tmmintrin.h>
+#endif
+
+#ifdef OSPIMGUI_HAVE_ZLIB
+#  include <zlib.h>
+#endif
+
+#include <ospcommon/tasking/parallel_for.h>
+
+namespace ospray {
+
+  using namespace ospcommon;
+
+  // Pixel conversion helpers /////////////////////////////////////////////////
+
+  static void rgba8ToRgb8(const uint32_t *in, uint8_t *out, int n)
+  {
+    int x = 0;
+
+#ifdef __SSSE3__
+    // NOTE: each store writes 16 bytes of which only the first 12 are valid,
+    //       so stop while there is still room for the 4 garbage bytes
+    const __m128i dropAlpha = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10,
+                                            12, 13, 14, -1, -1, -1, -1);
+    for (; x + 6 <= n; x += 4) {
+      auto rgba = _mm_loadu_si128((const __m128i*)(in + x));
+      _mm_storeu_si128((__m128i*)(out + 3 * x),
+                       _mm_shuffle_epi8(rgba, dropAlpha));
+    }
+#endif
+
+    auto *bytes = (const uint8_t*)in;
+    for (; x < n; ++x) {
+      out[3 * x + 0] = bytes[4 * x + 0];
+      out[3 * x + 1] = bytes[4 * x + 1];
+      out[3 * x + 2] = bytes[4 * x + 2];
+    }
+  }
+
+  /*! top-down RGB8 rows, each preceded by 'rowPrefix' zero bytes */
+  static std::vector<uint8_t> flippedRgb8(const vec2i &size,
+                                          const uint32_t *pixels,
+                                          size_t rowPrefix)
+  {
+    const size_t rowBytes = rowPrefix + 3 * size_t(size.x);
+    std::vector<uint8_t> rgb(rowBytes * size.y);
+
+    tasking::parallel_for(size.y, [&](int y) {
+      auto *out = rgb.data() + rowBytes * y;
+      std::memset(out, 0, rowPrefix);
+      rgba8ToRgb8(pixels + size_t(size.y - 1 - y) * size.x,
+                  out + rowPrefix, size.x);
+    });
+
+    return rgb;
+  }
+
+  // NOTE: all binary formats below are little-endian, as are the hosts we
+  //       build for, so values get copied in verbatim
+  struct ByteBuffer
+  {
+    std::vector<uint8_t> bytes;
+
+    template <typename T>
+    void put(const T &value)
+    {
+      auto *begin = (const uint8_t*)&value;
+      bytes.insert(bytes.end(), begin, begin + sizeof(T));
+    }
+
+    void put(const char *str)
+    {
+      bytes.insert(bytes.end(), str, str + std::strlen(str) + 1);
+    }
+
+    void putBigEndian(uint32_t value)
+    {
+      bytes.push_back(uint8_t(value >> 24));
+      bytes.push_back(uint8_t(value >> 16));
+      bytes.push_back(uint8_t(value >> 8));
+      bytes.push_back(uint8_t(value));
+    }
+  };
+
+  static bool writeFile(const std::string &fileName,
+                        const void *header, size_t headerSize,
+                        const void *data, size_t dataSize)
+  {
+    FILE *file = fopen(fileName.c_str(), "wb");
+    if (!file)
+      return false;
+
+    bool ok = fwrite(header, 1, headerSize, file) == headerSize &&
+              fwrite(data, 1, dataSize, file) == dataSize;
+
+    return fclose(file) == 0 && ok;
+  }
+
+  // PNG helpers //////////////////////////////////////////////////////////////
+
+  static uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0)
+  {
+    static const auto table = []() {
+      std::vector<uint32_t> t(256);
+      for (uint32_t n = 0; n < 256; ++n) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; ++k)
+          c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        t[n] = c;
+      }
+      return t;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i)
+      crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+  }
+
+  static void putChunk(ByteBuffer &png, const char *type,
+                       const uint8_t *data, size_t size)
+  {
+    png.putBigEndian(uint32_t(size));
+
+    auto crcStart = png.bytes.size();
+    png.bytes.insert(png.bytes.end(), type, type + 4);
+    png.bytes.insert(png.bytes.end(), data, data + size);
+
+    png.putBigEndian(crc32(png.bytes.data() + crcStart, size + 4));
+  }
+
+  /*! zlib stream of 'raw'; without zlib this falls back to stored
+      (uncompressed) deflate blocks, which every PNG reader still accepts */
+  static std::vector<uint8_t> zlibStream(const std::vector<uint8_t> &raw)
+  {
+#ifdef OSPIMGUI_HAVE_ZLIB
+    uLongf compressedSize = compressBound(raw.size());
+    std::vector<uint8_t> compressed(compressedSize);
+    if (compress2(compressed.data(), &compressedSize, raw.data(), raw.size(),
+                  Z_BEST_SPEED) == Z_OK) {
+      compressed.resize(compressedSize);
+      return compressed;
+    }
+#endif
+
+    ByteBuffer stream;
+    stream.bytes.push_back(0x78);
+    stream.bytes.push_back(0x01);
+
+    const size_t maxBlock = 65535;
+    size_t offset = 0;
+    do {
+      auto size = std::min(maxBlock, raw.size() - offset);
+      bool last = offset + size == raw.size();
+
+      stream.bytes.push_back(last ? 1 : 0);
+      stream.put(uint16_t(size));
+      stream.put(uint16_t(~size));
+      stream.bytes.insert(stream.bytes.end(), raw.begin() + offset,
+                          raw.begin() + offset + size);
+      offset += size;
+    } while (offset < raw.size());
+
+    uint32_t a = 1, b = 0;
+    for (auto byte : raw) {
+      a = (a + byte) % 65521;
+      b = (b + a) % 65521;
+    }
+    stream.putBigEndian((b << 16) | a);
+
+    return stream.bytes;
+  }
+
+  // Synchronous writers //////////////////////////////////////////////////////
+
+  bool writePPM(const std::string &fileName, const vec2i &size,
+                const uint32_t *pixels)
+  {
+    auto rgb = flippedRgb8(size, pixels, 0);
+
+    char header[64];
+    int headerSize = snprintf(header, sizeof(header), "P6\n%i %i\n255\n",
+                              size.x, size.y);
+
+    return writeFile(fileName, header, headerSize, rgb.data(), rgb.size());
+  }
+
+  bool writePNG(const std::string &fileName, const vec2i &size,
+                const uint32_t *pixels)
+  {
+    // NOTE: every row starts with its filter type, which is 0 (none)
+    auto idat = zlibStream(flippedRgb8(size, pixels, 1));
+
+    ByteBuffer ihdr;
+    ihdr.putBigEndian(size.x);
+    ihdr.putBigEndian(size.y);
+    ihdr.bytes.push_back(8); // bit depth
+    ihdr.bytes.push_back(2); // color type: RGB
+    ihdr.bytes.push_back(0); // compression: deflate
+    ihdr.bytes.push_back(0); // filter method
+    ihdr.bytes.push_back(0); // no interlacing
+
+    static const uint8_t signature[] = {137, 80, 78, 71, 13, 10, 26, 10};
+
+    ByteBuffer png;
+    png.bytes.assign(signature, signature + sizeof(signature));
+    putChunk(png, "IHDR", ihdr.bytes.data(), ihdr.bytes.size());
+    putChunk(png, "IDAT", idat.data(), idat.size());
+    putChunk(png, "IEND", nullptr, 0);
+
+    return writeFile(fileName, png.bytes.data(), png.bytes.size(),
+                     nullptr, 0);
+  }
+
+  bool writePFM(const std::string &fileName, const vec2i &size,
+                const float *pixels)
+  {
+    // NOTE: PFM stores rows bottom-up, just like OSPRay
+    const size_t nPixels = size_t(size.x) * size.y;
+    std::vector<float> rgb(3 * nPixels);
+
+    tasking::parallel_for(size.y, [&](int y) {
+      for (size_t i = size_t(y) * size.x; i < size_t(y + 1) * size.x; ++i) {
+        rgb[3 * i + 0] = pixels[4 * i + 0];
+        rgb[3 * i + 1] = pixels[4 * i + 1];
+        rgb[3 * i + 2] = pixels[4 * i + 2];
+      }
+    });
+
+    char header[64];
+    int headerSize = snprintf(header, sizeof(header), "PF\n%i %i\n-1.0\n",
+                              size.x, size.y);
+
+    return writeFile(fileName, header, headerSize,
+                     rgb.data(), rgb.size() * sizeof(float));
+  }
+
+  bool writeEXR(const std::string &fileName, const vec2i &size,
+                const float *pixels)
+  {
+    // NOTE: single-part, uncompressed scanline file with one scanline per
+    //       block; channels are stored in alphabetical order (B, G, R)
+    ByteBuffer header;
+    header.put(int32_t(20000630));
+    header.put(int32_t(2));
+
+    const char *channels[] = {"B", "G", "R"};
+
+    header.put("channels");
+    header.put("chlist");
+    header.put(int32_t(3 * (2 + 16) + 1));
+    for (auto *channel : channels) {
+      header.put(channel);
+      header.put(int32_t(2)); // FLOAT
+      header.put(int32_t(0)); // pLinear + reserved
+      header.put(int32_t(1)); // x sampling
+      header.put(int32_t(1)); // y sampling
+    }
+    header.bytes.push_back(0);
+
+    header.put("compression");
+    header.put("compression");
+    header.put(int32_t(1));
+    header.bytes.push_back(0); // NO_COMPRESSION
+
+    for (auto *window : {"dataWindow", "displayWindow"}) {
+      header.put(window);
+      header.put("box2i");
+      header.put(int32_t(16));
+      header.put(int32_t(0));
+      header.put(int32_t(0));
+      header.put(int32_t(size.x - 1));
+      header.put(int32_t(size.y - 1));
+    }
+
+    header.put("lineOrder");
+    header.put("lineOrder");
+    header.put(int32_t(1));
+    header.bytes.push_back(0); // INCREASING_Y
+
+    header.put("pixelAspectRatio");
+    header.put("float");
+    header.put(int32_t(4));
+    header.put(1.f);
+
+    header.put("screenWindowCenter");
+    header.put("v2f");
+    header.put(int32_t(8));
+    header.put(0.f);
+    header.put(0.f);
+
+    header.put("screenWindowWidth");
+    header.put("float");
+    header.put(int32_t(4));
+    header.put(1.f);
+
+    header.bytes.push_back(0);
+
+    const size_t rowBytes   = 3 * sizeof(float) * size.x;
+    const size_t blockBytes = 2 * sizeof(int32_t) + rowBytes;
+    const uint64_t firstBlock =
+        header.bytes.size() + sizeof(uint64_t) * size.y;
+
+    for (int y = 0; y < size.y; ++y)
+      header.put(uint64_t(firstBlock + y * blockBytes));
+
+    // NOTE: EXR scanlines go top-down
+    std::vector<uint8_t> blocks(blockBytes * size.y);
+
+    tasking::parallel_for(size.y, [&](int y) {
+      auto *block = blocks.data() + blockBytes * y;
+      int32_t blockHeader[2] = {y, int32_t(rowBytes)};
+      std::memcpy(block, blockHeader, sizeof(blockHeader));
+
+      auto *out = (float*)(block + sizeof(blockHeader));
+      auto *in  = pixels + 4 * size_t(size.y - 1 - y) * size.x;
+
+      for (int c = 0; c < 3; ++c) {
+        const int component = 2 - c;
+        for (int x = 0; x < size.x; ++x)
+          out[c * size.x + x] = in[4 * x + component];
+      }
+    });
+
+    return writeFile(fileName, header.bytes.data(), header.bytes.size(),
+                     blocks.data(), blocks.size());
+  }
+
+  // async_image_writer definitions ///////////////////////////////////////////
+
+  async_image_writer::async_image_writer(size_t maxQueued)
+    : maxQueued(std::max(maxQueued, size_t(1)))
+  {
+    worker = std::thread([&](){ run(); });
+  }
+
+  async_image_writer::~async_image_writer()
+  {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      quit = true;
+    }
+
+    jobAvailable.notify_one();
+    worker.join();
+  }
+
+  bool async_image_writer::write(const std::string &fileName,
+                                 ImageFormat format,
+                                 const vec2i &size,
+                                 Pixels8 pixels)
+  {
+    if (format != ImageFormat::PPM && format != ImageFormat::PNG)
+      return false;
+
+    Job job;
+    job.fileName = fileName;
+    job.format   = format;
+    job.size     = size;
+    job.pixels8  = std::move(pixels);
+
+    return enqueue(std::move(job));
+  }
+
+  bool async_image_writer::write(const std::string &fileName,
+                                 ImageFormat format,
+                                 const vec2i &size,
+                                 Pixels32 pixels)
+  {
+    if (format != ImageFormat::PFM && format != ImageFormat::EXR)
+      return false;
+
+    Job job;
+    job.fileName = fileName;
+    job.format   = format;
+    job.size     = size;
+    job.pixels32 = std::move(pixels);
+
+    return enqueue(std::move(job));
+  }
+
+  size_t async_image_writer::numQueued() const
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    return jobs.size();
+  }
+
+  bool async_image_writer::enqueue(Job job)
+  {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      if (jobs.size() >= maxQueued)
+        return false;
+
+      jobs.push_back(std::move(job));
+    }
+
+    jobAvailable.notify_one();
+    return true;
+  }
+
+  void async_image_writer::run()
+  {
+    while (true) {
+      Job job;
+
+      {
+        std::unique_lock<std::mutex> lock{mutex};
+        jobAvailable.wait(lock, [&](){ return quit || !jobs.empty(); });
+
+        // NOTE: finish writing everything queued before quitting
+        if (jobs.empty())
+          return;
+
+        job = std::move(jobs.front());
+        jobs.pop_front();
+      }
+
+      bool ok = false;
+
+      switch (job.format) {
+      case ImageFormat::PPM:
+        ok = writePPM(job.fileName, job.size, job.pixels8->data());
+        break;
+      case ImageFormat::PNG:
+        ok = writePNG(job.fileName, job.size, job.pixels8->data());
+        break;
+      case ImageFormat::PFM:
+        ok = writePFM(job.fileName, job.size, job.pixels32->data());
+        break;
+      case ImageFormat::EXR:
+        ok = writeEXR(job.fileName, job.size, job.pixels32->data());
+        break;
+      }
+
+      if (ok)
+        std::cout << "saved image to '" << job.fileName << "'" << std::endl;
+      else
+        std::cerr << "failed to write '" << job.fileName << "'" << std::endl;
+    }
+  }
+
+}// namespace ospray
@@ -0,0 +1,105 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+// std
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ospcommon
+#include <ospcommon/vec.h>
+
+// ospImGui util
+#include "ImguiUtilExport.h"
+
+namespace ospray {
+
+  enum class ImageFormat {PPM, PNG, PFM, EXR};
+
+  /*! writes images to disk on a background thread.
+
+      Queueing an image never blocks: if 'maxQueued' images are already
+      waiting, the new one is rejected instead. Pixel data is shared (not
+      copied), so it must not change until the writer lets go of it. Rows
+      are stored bottom-up, as they come out of OSPRay. */
+  class OSPRAY_IMGUI_UTIL_INTERFACE async_image_writer
+  {
+  public:
+
+    explicit async_image_writer(size_t maxQueued = 4);
+    ~async_image_writer();
+
+    using Pixels8  = std::shared_ptr<const std::vector<uint32_t>>;
+    using Pixels32 = std::shared_ptr<const std::vector<float>>;
+
+    /*! RGBA8 pixels, written as PPM or PNG */
+    bool write(const std::string &fileName, ImageFormat format,
+               const ospcommon::vec2i &size, Pixels8 pixels);
+    /*! linear RGBA32F pixels, written as PFM or EXR */
+    bool write(const std::string &fileName, ImageFormat format,
+               const ospcommon::vec2i &size, Pixels32 pixels);
+
+    size_t numQueued() const;
+
+  private:
+
+    struct Job
+    {
+      std::string      fileName;
+      ImageFormat      format;
+      ospcommon::vec2i size;
+      Pixels8          pixels8;
+      Pixels32         pixels32;
+    };
+
+    bool enqueue(Job job);
+    void run();
+
+    // Data //
+
+    size_t maxQueued;
+
+    mutable std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::deque<Job> jobs;
+    bool quit {false};
+
+    std::thread worker;
+  };
+
+  // Synchronous writers, returning false on failure //
+
+  OSPRAY_IMGUI_UTIL_INTERFACE
+  bool writePPM(const std::string &fileName, const ospcommon::vec2i &size,
+                const uint32_t *pixels);
+  OSPRAY_IMGUI_UTIL_INTERFACE
+  bool writePNG(const std::string &fileName, const ospcommon::vec2i &size,
+                const uint32_t *pixels);
+  OSPRAY_IMGUI_UTIL_INTERFACE
+  bool writePFM(const std::string &fileName, const ospcommon::vec2i &size,
+                const float *pixels);
+  OSPRAY_IMGUI_UTIL_INTERFACE
+  bool writeEXR(const std::string &fileName, const ospcommon::vec2i &size,
+                const float *pixels);
+
+}// namespace ospray
@@ -15,9 +15,33 @@
 // ======================================================================== //
 
 #include "async_render_engine.h"
+#include "startup_profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <unordered_map>
 
 namespace ospray {
 
+  /*! how long (in seconds) to keep rendering previews after the last
+      interaction before stepping back up to full resolution */
+  static const double previewHoldTime = 0.2;
+
+  /*! upper bound on the number of frames accumulated for a float capture */
+  static const int maxFloatCaptureFrames = 64;
+
+  static CommitOrder commitOrderOf(const cpp::ManagedObject &obj)
+  {
+    if (dynamic_cast<const cpp::Renderer*>(&obj))
+      return CommitOrder::RENDERER;
+    else if (dynamic_cast<const cpp::Camera*>(&obj))
+      return CommitOrder::CAMERA;
+    else if (dynamic_cast<const cpp::Model*>(&obj))
+      return CommitOrder::MODEL;
+    else
+      return CommitOrder::OBJECT;
+  }
+
   async_render_engine::~async_render_engine()
   {
     stop();
@@ -26,17 +50,120 @@ namespace ospray {
   void async_render_engine::setRenderer(cpp::Renderer renderer)
   {
     this->renderer = renderer;
+    wake();
   }
 
   void async_render_engine::setFbSize(const ospcommon::vec2i &size)
   {
     fbSize = size;
+    wake();
+  }
+
+  void async_render_engine::setPreviewScale(int scale)
+  {
+    previewScale = std::max(scale, 1);
+    wake();
+  }
+
+  void async_render_engine::notifyInteraction()
+  {
+    lastInteractionTime = ospcommon::getSysTime();
+  }
+
+  void async_render_engine::setMaxAccumFrames(int maxFrames)
+  {
+    maxAccumFrames = std::max(maxFrames, 0);
+    wake();
+  }
+
+  void async_render_engine::setVarianceThreshold(float threshold)
+  {
+    varianceThreshold = std::max(threshold, 0.f);
+    wake();
   }
 
-  void async_render_engine::scheduleObjectCommit(const cpp::ManagedObject &obj)
+  void async_render_engine::setDepthCapture(bool enabled)
   {
-    std::lock_guard<std::mutex> lock{objMutex};
-    objsToCommit.push_back(obj.object());
+    captureDepth = enabled;
+  }
+
+  void async_render_engine::requestFloatCapture(FloatCaptureCallback callback)
+  {
+    {
+      std::lock_guard<std::mutex> lock{floatCaptureMutex};
+      floatCaptureRequest = std::move(callback);
+    }
+
+    wake();
+  }
+
+  void async_render_engine::setFramePublishedCallback(
+      std::function<void()> callback)
+  {
+    framePublished = std::move(callback);
+  }
+
+  size_t async_render_engine::scheduleObjectCommit(const cpp::ManagedObject &obj,
+                                                   CommitOrder order)
+  {
+    auto generation = objsToCommit.push(obj.object(), order);
+    wake();
+    return generation;
+  }
+
+  size_t async_render_engine::scheduleObjectCommit(const cpp::Model &model)
+  {
+    return scheduleObjectCommit(model, CommitOrder::MODEL);
+  }
+
+  size_t async_render_engine::scheduleObjectCommit(const cpp::Camera &camera)
+  {
+    return scheduleObjectCommit(camera, CommitOrder::CAMERA);
+  }
+
+  size_t async_render_engine::scheduleObjectCommit(const cpp::Renderer &renderer)
+  {
+    return scheduleObjectCommit(renderer, CommitOrder::RENDERER);
+  }
+
+  size_t async_render_engine::scheduleParamChange(const cpp::ManagedObject &obj,
+                                                  const std::string &name,
+                                                  int value)
+  {
+    auto generation =
+        objsToCommit.setParam(obj.object(), commitOrderOf(obj), name, value);
+    wake();
+    return generation;
+  }
+
+  size_t async_render_engine::scheduleParamChange(const cpp::ManagedObject &obj,
+                                                  const std::string &name,
+                                                  float value)
+  {
+    auto generation =
+        objsToCommit.setParam(obj.object(), commitOrderOf(obj), name, value);
+    wake();
+    return generation;
+  }
+
+  size_t async_render_engine::scheduleParamChange(const cpp::ManagedObject &obj,
+                                                  const std::string &name,
+                                                  const ospcommon::vec3f &value)
+  {
+    auto generation =
+        objsToCommit.setParam(obj.object(), commitOrderOf(obj), name, value);
+    wake();
+    return generation;
+  }
+
+  size_t async_render_engine::scheduleParamChange(const cpp::ManagedObject &obj,
+                                                  const std::string &name,
+                                                  const cpp::ManagedObject &value)
+  {
+    auto generation = objsToCommit.setParam(obj.object(), commitOrderOf(obj),
+                                            name, value.object());
+    wake();
+    return generation;
   }
 
   void async_render_engine::start(int numThreads)
@@ -51,6 +178,8 @@ namespace ospray {
     if (state == ExecState::INVALID)
       throw std::runtime_error("Can't start the engine in an invalid state!");
 
+    startup_profiler::instance().begin("engine: start -> first frame");
+
     state = ExecState::RUNNING;
     backgroundThread = std::thread(&async_render_engine::run, this);
   }
@@ -61,6 +190,7 @@ namespace ospray {
       return;
 
     state = ExecState::STOPPED;
+    wake();
     if (backgroundThread.joinable())
       backgroundThread.join();
   }
@@ -72,7 +202,7 @@ namespace ospray {
 
   bool async_render_engine::hasNewFrame() const
   {
-    return newPixels;
+    return frames.hasNew();
   }
 
   double async_render_engine::lastFrameFps() const
@@ -80,16 +210,79 @@ namespace ospray {
     return fps.getFPS();
   }
 
-  const std::vector<uint32_t> &async_render_engine::mapFramebuffer()
+  double async_render_engine::lastFrameRenderTime() const
+  {
+    return lastRenderTime;
+  }
+
+  int async_render_engine::accumulatedFrames() const
+  {
+    return accumFrames;
+  }
+
+  float async_render_engine::estimatedVariance() const
+  {
+    return variance;
+  }
+
+  int async_render_engine::lastFrameCommits() const
+  {
+    return frameCommits;
+  }
+
+  std::vector<FrameTiming> async_render_engine::timingHistory() const
+  {
+    auto history = timings.snapshot();
+    auto uploads = uploadTimings.snapshot();
+
+    std::unordered_map<size_t, double> uploadTimeOf;
+    for (auto &upload : uploads)
+      uploadTimeOf[upload.frameId] = upload.seconds;
+
+    for (auto &timing : history) {
+      auto upload = uploadTimeOf.find(timing.frameId);
+      if (upload != uploadTimeOf.end())
+        timing.upload = upload->second;
+    }
+
+    return history;
+  }
+
+  bool async_render_engine::dumpTimingsCSV(const std::string &fileName) const
+  {
+    std::ofstream out(fileName);
+    if (!out.is_open())
+      return false;
+
+    out << "frame,commit_ms,resize_ms,render_ms,map_ms,copy_ms,publish_ms,"
+        << "upload_ms" << std::endl;
+
+    for (auto &t : timingHistory()) {
+      out << t.frameId          << ','
+          << t.commit  * 1000.0 << ','
+          << t.resize  * 1000.0 << ','
+          << t.render  * 1000.0 << ','
+          << t.map     * 1000.0 << ','
+          << t.copy    * 1000.0 << ','
+          << t.publish * 1000.0 << ','
+          << t.upload  * 1000.0 << std::endl;
+    }
+
+    return true;
+  }
+
+  void async_render_engine::recordUploadTime(size_t frameId, double seconds)
   {
-    fbMutex.lock();
-    newPixels = false;
-    return pixelBuffer[mappedPB];
+    UploadTiming timing;
+    timing.frameId = frameId;
+    timing.seconds = seconds;
+    uploadTimings.push(timing);
   }
 
-  void async_render_engine::unmapFramebuffer()
+  FrameHandle async_render_engine::acquireFrame()
   {
-    fbMutex.unlock();
+    frames.update();
+    return frames.front();
   }
 
   void async_render_engine::validate()
@@ -103,38 +296,108 @@ namespace ospray {
 
   bool async_render_engine::checkForObjCommits()
   {
-    bool commitOccurred = false;
+    frameCommits = objsToCommit.flush();
 
-    if (!objsToCommit.empty()) {
-      std::lock_guard<std::mutex> lock{objMutex};
+    if (frameCommits > 0)
+      lastCommitTime = monotonicTime();
 
-      for (auto obj : objsToCommit)
-        ospCommit(obj);
-
-      objsToCommit.clear();
-      commitOccurred = true;
-    }
-
-    return commitOccurred;
+    return frameCommits > 0;
   }
 
   bool async_render_engine::checkForFbResize()
   {
     bool changed = fbSize.update();
+    changed |= previewScale.update();
 
     if (changed) {
       auto &size  = fbSize.ref();
       frameBuffer = cpp::FrameBuffer(osp::vec2i{size.x, size.y}, OSP_FB_SRGBA,
-                                     OSP_FB_COLOR | OSP_FB_DEPTH | OSP_FB_ACCUM);
+                                     OSP_FB_COLOR | OSP_FB_DEPTH |
+                                     OSP_FB_ACCUM | OSP_FB_VARIANCE);
 
       nPixels = size.x * size.y;
-      pixelBuffer[0].resize(nPixels);
-      pixelBuffer[1].resize(nPixels);
+
+      auto scale = previewScale.ref();
+      if (scale > 1) {
+        previewSize.x = std::max(size.x / scale, 1);
+        previewSize.y = std::max(size.y / scale, 1);
+        previewFrameBuffer =
+            cpp::FrameBuffer(osp::vec2i{previewSize.x, previewSize.y},
+                             OSP_FB_SRGBA,
+                             OSP_FB_COLOR | OSP_FB_DEPTH | OSP_FB_ACCUM);
+
+        nPreviewPixels = previewSize.x * previewSize.y;
+      }
     }
 
     return changed;
   }
 
+  bool async_render_engine::isConverged() const
+  {
+    if (maxAccumFrames > 0 && accumFrames >= maxAccumFrames)
+      return true;
+
+    if (varianceThreshold > 0.f && variance <= varianceThreshold)
+      return true;
+
+    return false;
+  }
+
+  void async_render_engine::captureFloatFrame()
+  {
+    FloatCaptureCallback callback;
+
+    {
+      std::lock_guard<std::mutex> lock{floatCaptureMutex};
+      std::swap(callback, floatCaptureRequest);
+    }
+
+    if (!callback)
+      return;
+
+    // NOTE: the display frame buffer only keeps 8 bit sRGB colors, so render
+    //       the image again into a linear float one, accumulating up to the
+    //       same sample count
+    auto &size = fbSize.ref();
+    cpp::FrameBuffer floatFrameBuffer(osp::vec2i{size.x, size.y},
+                                      OSP_FB_RGBA32F,
+                                      OSP_FB_COLOR | OSP_FB_ACCUM);
+    floatFrameBuffer.clear(OSP_FB_COLOR | OSP_FB_ACCUM);
+
+    const int numFrames = std::min(std::max(accumFrames.load(), 1),
+                                   maxFloatCaptureFrames);
+
+    for (int i = 0; i < numFrames; ++i) {
+      renderer.ref().renderFrame(floatFrameBuffer,
+                                 OSP_FB_COLOR | OSP_FB_ACCUM);
+    }
+
+    auto *src = (float*)floatFrameBuffer.map(OSP_FB_COLOR);
+    auto pixels = std::make_shared<std::vector<float>>(src, src + 4 * nPixels);
+    floatFrameBuffer.unmap(src);
+
+    callback(size, std::move(pixels));
+  }
+
+  void async_render_engine::wake()
+  {
+    {
+      std::lock_guard<std::mutex> lock{wakeMutex};
+      wakeRequested = true;
+    }
+
+    wakeCondition.notify_one();
+  }
+
+  void async_render_engine::waitForWake()
+  {
+    std::unique_lock<std::mutex> lock{wakeMutex};
+    wakeCondition.wait(lock, [&](){
+      return wakeRequested || state != ExecState::RUNNING;
+    });
+  }
+
   void async_render_engine::run()
   {
     auto device = ospGetCurrentDevice();
@@ -143,31 +406,120 @@ namespace ospray {
     ospDeviceCommit(device);
 
     while (state == ExecState::RUNNING) {
+      // NOTE: clear the wake flag before looking for changes, so that any
+      //       change made after this point wakes the idle wait below
+      {
+        std::lock_guard<std::mutex> lock{wakeMutex};
+        wakeRequested = false;
+      }
+
+      FrameTiming timing;
+      timing.frameId = ++frameCounter;
+
+      auto stageStart = ospcommon::getSysTime();
+      auto endStage   = [&](double &stageTime) {
+        auto now   = ospcommon::getSysTime();
+        stageTime  = now - stageStart;
+        stageStart = now;
+      };
+
+      // NOTE: the first commit is where OSPRay builds the scene's BVHs
+      const bool firstFrame = timing.frameId == 1;
+      if (firstFrame)
+        startup_profiler::instance().begin("engine: first commit");
+
       bool resetAccum = false;
       resetAccum |= renderer.update();
-      resetAccum |= checkForFbResize();
       resetAccum |= checkForObjCommits();
+      endStage(timing.commit);
+
+      if (firstFrame)
+        startup_profiler::instance().end("engine: first commit");
+
+      resetAccum |= checkForFbResize();
+      endStage(timing.resize);
 
-      if (resetAccum)
+      // NOTE: a float capture is not part of producing this frame, so keep
+      //       it out of the render stage's time
+      captureFloatFrame();
+      stageStart = ospcommon::getSysTime();
+
+      bool usePreview = previewScale.ref() > 1 &&
+          ospcommon::getSysTime() - lastInteractionTime < previewHoldTime;
+
+      if (resetAccum) {
         frameBuffer.clear(OSP_FB_ACCUM);
+        if (previewScale.ref() > 1)
+          previewFrameBuffer.clear(OSP_FB_ACCUM);
+
+        accumFrames = 0;
+        variance    = std::numeric_limits<float>::infinity();
+      }
+
+      auto &fb           = usePreview ? previewFrameBuffer : frameBuffer;
+      auto &size         = usePreview ? previewSize : fbSize.ref();
+      auto  nFramePixels = usePreview ? nPreviewPixels : nPixels;
 
       fps.startRender();
-      renderer.ref().renderFrame(frameBuffer, OSP_FB_COLOR | OSP_FB_ACCUM);
+      auto frameVariance = renderer.ref().renderFrame(fb, OSP_FB_COLOR |
+                                                          OSP_FB_ACCUM |
+                                                          OSP_FB_VARIANCE);
       fps.doneRender();
+      endStage(timing.render);
+      lastRenderTime = timing.render;
+
+      // NOTE: preview frames don't contribute to the full-resolution
+      //       accumulation, so they never count towards convergence
+      if (!usePreview) {
+        accumFrames++;
+        variance = frameVariance;
+      }
 
-      auto *srcPB = (uint32_t*)frameBuffer.map(OSP_FB_COLOR);
-      auto *dstPB = (uint32_t*)pixelBuffer[currentPB].data();
+      auto *srcPB = (uint32_t*)fb.map(OSP_FB_COLOR);
+      auto *srcDB = captureDepth ? (float*)fb.map(OSP_FB_DEPTH) : nullptr;
+      endStage(timing.map);
 
-      memcpy(dstPB, srcPB, nPixels*sizeof(uint32_t));
+      // NOTE: a frame still referenced by a consumer handle is never reused,
+      //       so only write into the back frame if we are its sole owner
+      auto &frame = frames.back();
+      if (!frame || frame.use_count() > 1)
+        frame = std::make_shared<RenderedFrame>();
 
-      frameBuffer.unmap(srcPB);
+      frame->id          = timing.frameId;
+      frame->size        = size;
+      frame->generation  = objsToCommit.committedGeneration();
+      frame->commitTime  = lastCommitTime;
+      frame->accumulated = usePreview ? 0 : accumFrames.load();
+      frame->color.resize(nFramePixels);
 
-      if (fbMutex.try_lock())
-      {
-        std::swap(currentPB, mappedPB);
-        newPixels = true;
-        fbMutex.unlock();
-      }
+      auto *dstPB = (uint32_t*)frame->color.data();
+      memcpy(dstPB, srcPB, nFramePixels*sizeof(uint32_t));
+
+      if (srcDB)
+        frame->depth.assign(srcDB, srcDB + nFramePixels);
+      else
+        frame->depth.clear();
+
+      endStage(timing.copy);
+
+      fb.unmap(srcPB);
+      if (srcDB)
+        fb.unmap(srcDB);
+
+      frame->doneTime = monotonicTime();
+      frames.publish();
+      endStage(timing.publish);
+
+      if (firstFrame)
+        startup_profiler::instance().end("engine: start -> first frame");
+
+      if (framePublished)
+        framePublished();
+
+      timings.push(timing);
+
+      if (!usePreview && isConverged())
+        waitForWake();
     }
   }
 
@@ -18,6 +18,11 @@
 
 // std
 #include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -25,17 +30,61 @@
 #include <ospcommon/box.h>
 
 // ospray::cpp
+#include <ospray/ospray_cpp/Camera.h>
+#include <ospray/ospray_cpp/Model.h>
 #include <ospray/ospray_cpp/Renderer.h>
 
 // ospImGui util
 #include "ImguiUtilExport.h"
+#include "commit_queue.h"
 #include "FPSCounter.h"
+#include "latency_tracker.h"
+#include "ring_buffer.h"
 #include "transactional_value.h"
+#include "triple_buffer.h"
 
 namespace ospray {
 
   enum class ExecState {STOPPED, RUNNING, INVALID};
 
+  /*! a finished frame, owned by the engine and shared with its consumers */
+  struct RenderedFrame
+  {
+    size_t                id {0};
+    ospcommon::vec2i      size;
+    std::vector<uint32_t> color;
+    /*! distance along each pixel's (normalized) camera ray, only filled in
+        while depth capture is enabled (\see setDepthCapture()) */
+    std::vector<float>    depth;
+
+    /*! commit generation this frame was rendered with: it reflects every
+        change scheduled with a generation up to (and including) this one */
+    size_t generation {0};
+    /*! monotonicTime() at which that generation's commits were applied */
+    double commitTime {0.0};
+    /*! monotonicTime() at which the frame was finished */
+    double doneTime   {0.0};
+    /*! full-resolution frames accumulated into this one (0 for previews) */
+    int    accumulated {0};
+  };
+
+  /*! time spent (in seconds) in each stage of producing a single frame */
+  struct FrameTiming
+  {
+    size_t frameId {0};
+    double commit  {0.0}; // parameter/commit application
+    double resize  {0.0}; // frame buffer (re)allocation
+    double render  {0.0}; // renderFrame()
+    double map     {0.0}; // mapping the OSPRay frame buffer
+    double copy    {0.0}; // copying pixels into the published frame
+    double publish {0.0}; // handing the frame over to the consumer
+    double upload  {0.0}; // consumer side upload, if it reported one
+  };
+
+  /*! reference-counted handle to a published frame: the engine will never
+      write into a frame while a handle to it is still alive */
+  using FrameHandle = std::shared_ptr<const RenderedFrame>;
+
   class OSPRAY_IMGUI_UTIL_INTERFACE async_render_engine
   {
   public:
@@ -48,9 +97,57 @@ namespace ospray {
     void setRenderer(cpp::Renderer renderer);
     void setFbSize(const ospcommon::vec2i &size);
 
-    // Method to say that an objects needs to be comitted before next frame //
+    // Reduced-resolution preview (scale of 1 disables it) //
+
+    void setPreviewScale(int scale);
+    void notifyInteraction();
+
+    // Convergence criteria (a value of 0 disables the criterion) //
+
+    void setMaxAccumFrames(int maxFrames);
+    void setVarianceThreshold(float threshold);
+
+    // Also copy the depth channel into published frames //
+
+    void setDepthCapture(bool enabled);
+
+    // Render a full precision (linear RGBA32F) copy of the current image with
+    // as many samples as have been accumulated so far; the callback gets run
+    // on the render thread once it is done //
+
+    using FloatPixels = std::shared_ptr<const std::vector<float>>;
+    using FloatCaptureCallback =
+        std::function<void(const ospcommon::vec2i &size, FloatPixels pixels)>;
+
+    void requestFloatCapture(FloatCaptureCallback callback);
+
+    // Called on the render thread each time a frame gets published; only set
+    // this while the engine is stopped //
+
+    void setFramePublishedCallback(std::function<void()> callback);
 
-    void scheduleObjectCommit(const cpp::ManagedObject &obj);
+    // Methods to say that an objects needs to be comitted before next frame,
+    // returning the generation number of the scheduled change //
+
+    size_t scheduleObjectCommit(const cpp::ManagedObject &obj,
+                                CommitOrder order = CommitOrder::OBJECT);
+    size_t scheduleObjectCommit(const cpp::Model &model);
+    size_t scheduleObjectCommit(const cpp::Camera &camera);
+    size_t scheduleObjectCommit(const cpp::Renderer &renderer);
+
+    // Methods to record a parameter change, which is set on the render thread
+    // at the next frame boundary followed by a single commit of the object //
+
+    size_t scheduleParamChange(const cpp::ManagedObject &obj,
+                               const std::string &name, int value);
+    size_t scheduleParamChange(const cpp::ManagedObject &obj,
+                               const std::string &name, float value);
+    size_t scheduleParamChange(const cpp::ManagedObject &obj,
+                               const std::string &name,
+                               const ospcommon::vec3f &value);
+    size_t scheduleParamChange(const cpp::ManagedObject &obj,
+                               const std::string &name,
+                               const cpp::ManagedObject &value);
 
     // Engine conrols //
 
@@ -63,9 +160,21 @@ namespace ospray {
 
     bool   hasNewFrame() const;
     double lastFrameFps() const;
+    double lastFrameRenderTime() const;
+
+    int   accumulatedFrames() const;
+    float estimatedVariance() const;
+
+    int lastFrameCommits() const;
 
-    const std::vector<uint32_t> &mapFramebuffer();
-    void                         unmapFramebuffer();
+    // Per-stage timing history of the most recent frames //
+
+    std::vector<FrameTiming> timingHistory() const;
+    bool dumpTimingsCSV(const std::string &fileName) const;
+
+    void recordUploadTime(size_t frameId, double seconds);
+
+    FrameHandle acquireFrame();
 
   private:
 
@@ -74,6 +183,10 @@ namespace ospray {
     void validate();
     bool checkForObjCommits();
     bool checkForFbResize();
+    bool isConverged() const;
+    void captureFloatFrame();
+    void wake();
+    void waitForWake();
     void run();
 
     // Data //
@@ -84,23 +197,55 @@ namespace ospray {
     std::atomic<ExecState> state {ExecState::INVALID};
 
     cpp::FrameBuffer frameBuffer;
+    cpp::FrameBuffer previewFrameBuffer;
 
     transactional_value<cpp::Renderer>    renderer;
     transactional_value<ospcommon::vec2i> fbSize;
+    transactional_value<int>              previewScale {1};
 
     int nPixels {0};
 
-    int currentPB {0};
-    int mappedPB  {1};
-    std::mutex fbMutex;
-    std::vector<uint32_t> pixelBuffer[2];
+    ospcommon::vec2i previewSize;
+    int nPreviewPixels {0};
+
+    std::atomic<double> lastInteractionTime {0.0};
 
-    std::mutex objMutex;
-    std::vector<OSPObject> objsToCommit;
+    std::atomic<int>   maxAccumFrames    {0};
+    std::atomic<float> varianceThreshold {0.f};
 
-    std::atomic<bool> newPixels {false};
+    std::atomic<int>   accumFrames {0};
+    std::atomic<float> variance    {std::numeric_limits<float>::infinity()};
+
+    std::atomic<bool> captureDepth {false};
+
+    std::mutex floatCaptureMutex;
+    FloatCaptureCallback floatCaptureRequest;
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    bool wakeRequested {false};
+
+    triple_buffer<std::shared_ptr<RenderedFrame>> frames;
+    std::function<void()> framePublished;
+
+    commit_queue objsToCommit;
+    std::atomic<int> frameCommits {0};
+    double lastCommitTime {0.0};
 
     FPSCounter fps;
+    std::atomic<double> lastRenderTime {0.0};
+
+    static const size_t TIMING_HISTORY_SIZE = 1024;
+
+    struct UploadTiming
+    {
+      size_t frameId {0};
+      double seconds {0.0};
+    };
+
+    size_t frameCounter {0};
+    ring_buffer<FrameTiming, TIMING_HISTORY_SIZE>  timings;
+    ring_buffer<UploadTiming, TIMING_HISTORY_SIZE> uploadTimings;
   };
 
 }// namespace ospray
@@ -0,0 +1,171 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "camera_path.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace ospray {
+
+  // NOTE: the file is a magic string and version followed by the keyframe
+  //       count and the keyframes themselves, all little-endian
+  static const char     pathMagic[8] = {'O','S','P','C','P','A','T','H'};
+  static const uint32_t pathVersion  = 1;
+
+  struct PackedKeyframe
+  {
+    double time;
+    float  from[3];
+    float  at[3];
+    float  up[3];
+    float  fovy;
+  };
+
+  static_assert(sizeof(PackedKeyframe) == 48,
+                "camera path keyframes must stay 48 bytes on disk");
+
+  void camera_path::clear()
+  {
+    keyframes.clear();
+  }
+
+  void camera_path::add(const CameraKeyframe &keyframe)
+  {
+    keyframes.push_back(keyframe);
+  }
+
+  bool camera_path::empty() const
+  {
+    return keyframes.empty();
+  }
+
+  size_t camera_path::size() const
+  {
+    return keyframes.size();
+  }
+
+  const CameraKeyframe &camera_path::operator[](size_t i) const
+  {
+    return keyframes[i];
+  }
+
+  bool camera_path::save(const std::string &fileName) const
+  {
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out.is_open())
+      return false;
+
+    const uint32_t count = keyframes.size();
+
+    out.write(pathMagic, sizeof(pathMagic));
+    out.write((const char*)&pathVersion, sizeof(pathVersion));
+    out.write((const char*)&count, sizeof(count));
+
+    for (auto &k : keyframes) {
+      PackedKeyframe packed;
+      packed.time = k.time;
+      std::memcpy(packed.from, &k.from, sizeof(packed.from));
+      std::memcpy(packed.at,   &k.at,   sizeof(packed.at));
+      std::memcpy(packed.up,   &k.up,   sizeof(packed.up));
+      packed.fovy = k.fovy;
+      out.write((const char*)&packed, sizeof(packed));
+    }
+
+    return out.good();
+  }
+
+  bool camera_path::load(const std::string &fileName)
+  {
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in.is_open())
+      return false;
+
+    char magic[sizeof(pathMagic)];
+    uint32_t version = 0;
+    uint32_t count   = 0;
+
+    in.read(magic, sizeof(magic));
+    in.read((char*)&version, sizeof(version));
+    in.read((char*)&count, sizeof(count));
+
+    if (!in || std::memcmp(magic, pathMagic, sizeof(magic)) != 0 ||
+        version != pathVersion) {
+      return false;
+    }
+
+    std::vector<CameraKeyframe> loaded;
+    loaded.reserve(count);
+
+    for (uint32_t i = 0; i < count; ++i) {
+      PackedKeyframe packed;
+      if (!in.read((char*)&packed, sizeof(packed)))
+        return false;
+
+      CameraKeyframe k;
+      k.time = packed.time;
+      std::memcpy(&k.from, packed.from, sizeof(packed.from));
+      std::memcpy(&k.at,   packed.at,   sizeof(packed.at));
+      std::memcpy(&k.up,   packed.up,   sizeof(packed.up));
+      k.fovy = packed.fovy;
+      loaded.push_back(k);
+    }
+
+    keyframes.swap(loaded);
+    return true;
+  }
+
+  void printReplayReport(FILE *out,
+                         const camera_path &path,
+                         const std::vector<double> &keyframeSeconds,
+                         int framesPerKeyframe)
+  {
+    auto sorted = keyframeSeconds;
+    std::sort(sorted.begin(), sorted.end());
+
+    double total = 0.0;
+    for (auto t : sorted)
+      total += t;
+
+    const auto n = sorted.size();
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"keyframes\": %i,\n", int(n));
+    fprintf(out, "  \"frames_per_keyframe\": %i,\n", framesPerKeyframe);
+    fprintf(out, "  \"total_ms\": %f,\n", total * 1000.0);
+    fprintf(out, "  \"mean_ms\": %f,\n", n ? total * 1000.0 / n : 0.0);
+    fprintf(out, "  \"min_ms\": %f,\n", n ? sorted.front() * 1000.0 : 0.0);
+    fprintf(out, "  \"max_ms\": %f,\n", n ? sorted.back() * 1000.0 : 0.0);
+    fprintf(out, "  \"keyframe_ms\": [");
+
+    for (size_t i = 0; i < keyframeSeconds.size(); ++i) {
+      fprintf(out, "%s%s%f", i ? "," : "", i % 8 ? " " : "\n    ",
+              keyframeSeconds[i] * 1000.0);
+    }
+
+    fprintf(out, "\n  ],\n");
+    fprintf(out, "  \"keyframe_time_s\": [");
+
+    for (size_t i = 0; i < path.size() && i < keyframeSeconds.size(); ++i)
+      fprintf(out, "%s%s%f", i ? "," : "", i % 8 ? " " : "\n    ", path[i].time);
+
+    fprintf(out, "\n  ]\n");
+    fprintf(out, "}\n");
+    fflush(out);
+  }
+
+}// namespace ospray
@@ -0,0 +1,74 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+// std
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// ospcommon
+#include <ospcommon/vec.h>
+
+// ospImGui util
+#include "ImguiUtilExport.h"
+
+namespace ospray {
+
+  struct CameraKeyframe
+  {
+    double           time {0.0}; // seconds since the recording started
+    ospcommon::vec3f from;
+    ospcommon::vec3f at;
+    ospcommon::vec3f up;
+    float            fovy {60.f};
+  };
+
+  /*! a recorded camera trajectory, stored in a small binary file so that
+      exactly the same views can be rendered again later */
+  class OSPRAY_IMGUI_UTIL_INTERFACE camera_path
+  {
+  public:
+
+    camera_path()  = default;
+    ~camera_path() = default;
+
+    void clear();
+    void add(const CameraKeyframe &keyframe);
+
+    bool   empty() const;
+    size_t size() const;
+
+    const CameraKeyframe &operator[](size_t i) const;
+
+    bool save(const std::string &fileName) const;
+    bool load(const std::string &fileName);
+
+  private:
+
+    std::vector<CameraKeyframe> keyframes;
+  };
+
+  /*! print per-keyframe render times of a replayed path as JSON, in the
+      same form for windowed and headless replays so runs can be diffed */
+  OSPRAY_IMGUI_UTIL_INTERFACE
+  void printReplayReport(FILE *out,
+                         const camera_path &path,
+                         const std::vector<double> &keyframeSeconds,
+                         int framesPerKeyframe);
+
+}// namespace ospray
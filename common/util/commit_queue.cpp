@@ -0,0 +1,80 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "commit_queue.h"
+
+#include <algorithm>
+
+namespace ospray {
+
+  size_t commit_queue::push(OSPObject obj, CommitOrder order)
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    return schedule(obj, order);
+  }
+
+  size_t commit_queue::flush()
+  {
+    std::vector<Entry> toCommit;
+    param_journal      toApply;
+    size_t generation = 0;
+
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      toCommit.swap(entries);
+      std::swap(toApply, journal);
+      generation = scheduled;
+    }
+
+    toApply.apply();
+
+    std::stable_sort(toCommit.begin(), toCommit.end(),
+                     [](const Entry &a, const Entry &b){
+                       return a.order < b.order;
+                     });
+
+    for (auto &entry : toCommit)
+      ospCommit(entry.object);
+
+    committed = generation;
+
+    return toCommit.size();
+  }
+
+  size_t commit_queue::scheduledGeneration() const
+  {
+    return scheduled;
+  }
+
+  size_t commit_queue::committedGeneration() const
+  {
+    return committed;
+  }
+
+  size_t commit_queue::schedule(OSPObject obj, CommitOrder order)
+  {
+    auto entry = std::find_if(entries.begin(), entries.end(),
+                              [&](const Entry &e){ return e.object == obj; });
+
+    if (entry == entries.end())
+      entries.push_back({obj, order});
+    else
+      entry->order = std::max(entry->order, order);
+
+    return ++scheduled;
+  }
+
+}// namespace ospray
@@ -0,0 +1,90 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+// std
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// ospray
+#include <ospray/ospray.h>
+
+// ospImGui util
+#include "ImguiUtilExport.h"
+#include "param_journal.h"
+
+namespace ospray {
+
+  /*! the order in which scheduled objects get committed: everything an
+      object references has to be committed before the object itself */
+  enum class CommitOrder {OBJECT, MODEL, CAMERA, RENDERER};
+
+  /*! thread-safe set of objects waiting to be committed, along with the
+      parameter changes to set on them first. Scheduling the same object
+      more than once before the next flush only commits it once, and every
+      schedule bumps a generation number so consumers can tell which
+      changes a flush covered. */
+  class OSPRAY_IMGUI_UTIL_INTERFACE commit_queue
+  {
+  public:
+
+    commit_queue()  = default;
+    ~commit_queue() = default;
+
+    size_t push(OSPObject obj, CommitOrder order);
+
+    template <typename T>
+    size_t setParam(OSPObject obj, CommitOrder order,
+                    const std::string &name, const T &value);
+
+    size_t flush();
+
+    size_t scheduledGeneration() const;
+    size_t committedGeneration() const;
+
+  private:
+
+    struct Entry
+    {
+      OSPObject   object;
+      CommitOrder order;
+    };
+
+    size_t schedule(OSPObject obj, CommitOrder order);
+
+    std::mutex mutex;
+    std::vector<Entry> entries;
+    param_journal journal;
+
+    std::atomic<size_t> scheduled {0};
+    std::atomic<size_t> committed {0};
+  };
+
+  // Inlined commit_queue Members ///////////////////////////////////////////
+
+  template <typename T>
+  inline size_t commit_queue::setParam(OSPObject obj, CommitOrder order,
+                                       const std::string &name, const T &value)
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    journal.record(obj, name, value);
+    return schedule(obj, order);
+  }
+
+}// namespace ospray
@@ -0,0 +1,420 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "frame_recorder.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#  include <fcntl.h>
+#  include <io.h>
+#  include <sys/stat.h>
+#else
+#  include <fcntl.h>
+#  include <poll.h>
+#  include <unistd.h>
+#endif
+
+namespace ospray {
+
+  using namespace ospcommon;
+
+  // how long stop() waits for the output to take what is left
+  static const auto stopTimeout = std::chrono::seconds(3);
+
+  static int openOutput(const std::string &path)
+  {
+#ifdef _WIN32
+    int fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY,
+                   _S_IREAD | _S_IWRITE);
+#else
+    // NOTE: non-blocking, so a named pipe without a reader fails right away
+    //       instead of hanging, and writes can be given up on in stop()
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_NONBLOCK,
+                  0644);
+    if (fd < 0 && errno == ENXIO) {
+      std::cerr << "nothing is reading from '" << path << "', start the "
+                << "reader of the pipe before recording" << std::endl;
+      return -1;
+    }
+#endif
+
+    if (fd < 0) {
+      std::cerr << "could not open '" << path << "' for recording: "
+                << strerror(errno) << std::endl;
+    }
+
+    return fd;
+  }
+
+  static void closeOutput(int fd)
+  {
+#ifdef _WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+  }
+
+  frame_recorder::~frame_recorder()
+  {
+    stop();
+  }
+
+  bool frame_recorder::start(const RecordingSettings &newSettings)
+  {
+    if (recording)
+      return false;
+
+    if (newSettings.size.x <= 0 || newSettings.size.y <= 0 ||
+        newSettings.path.empty()) {
+      return false;
+    }
+
+    output = openOutput(newSettings.path);
+    if (output < 0)
+      return false;
+
+    settings = newSettings;
+    settings.fps        = std::max(settings.fps, 1);
+    settings.numBuffers = std::max(settings.numBuffers, 1);
+    settings.numWorkers = std::max(settings.numWorkers, 1);
+
+    const size_t nPixels = size_t(settings.size.x) * settings.size.y;
+
+    buffers.resize(settings.numBuffers);
+    freeBuffers.clear();
+    for (int i = 0; i < settings.numBuffers; ++i) {
+      buffers[i].rgba.resize(nPixels);
+      freeBuffers.push_back(i);
+    }
+
+    toEncode.clear();
+    toWrite.clear();
+
+    nextSequence = 0;
+    stopping     = false;
+    writerDone   = false;
+    counters     = RecordingStats();
+
+    aborting  = false;
+    recording = true;
+
+    for (int i = 0; i < settings.numWorkers; ++i)
+      encoders.emplace_back([&](){ encodeFrames(); });
+
+    writer = std::thread([&](){ writeFrames(); });
+
+    return true;
+  }
+
+  void frame_recorder::stop()
+  {
+    if (!recording)
+      return;
+
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      stopping = true;
+    }
+
+    bufferFreed.notify_all();
+    frameSubmitted.notify_all();
+    frameEncoded.notify_all();
+
+    for (auto &encoder : encoders)
+      encoder.join();
+    encoders.clear();
+
+    // NOTE: stop() runs on the UI thread, so don't wait forever on a pipe
+    //       whose reader stopped reading
+    {
+      std::unique_lock<std::mutex> lock{mutex};
+      if (!writerFinished.wait_for(lock, stopTimeout,
+                                   [&](){ return writerDone; })) {
+        std::cerr << "recording output '" << settings.path << "' stopped "
+                  << "taking frames, dropping the rest" << std::endl;
+        counters.failed = true;
+        aborting        = true;
+      }
+    }
+
+    frameEncoded.notify_all();
+    writer.join();
+
+    closeOutput(output);
+    output = -1;
+
+    // NOTE: give the memory back, recordings can use a lot of it
+    buffers.clear();
+    buffers.shrink_to_fit();
+
+    recording = false;
+  }
+
+  bool frame_recorder::isRecording() const
+  {
+    return recording;
+  }
+
+  bool frame_recorder::submit(const uint32_t *pixels, const vec2i &size)
+  {
+    if (!recording || size.x <= 0 || size.y <= 0)
+      return false;
+
+    int index = -1;
+
+    {
+      std::unique_lock<std::mutex> lock{mutex};
+      counters.submitted++;
+
+      if (freeBuffers.empty()) {
+        if (settings.policy == RecordingPolicy::DROP) {
+          counters.dropped++;
+          return false;
+        }
+
+        counters.blocked++;
+        bufferFreed.wait(lock, [&](){
+          return !freeBuffers.empty() || stopping;
+        });
+
+        if (freeBuffers.empty()) {
+          counters.dropped++;
+          return false;
+        }
+      }
+
+      index = freeBuffers.front();
+      freeBuffers.pop_front();
+      buffers[index].sequence = nextSequence++;
+    }
+
+    // NOTE: the buffer is ours alone until it gets queued for encoding, so
+    //       copy without holding the lock; frames of a different size (like
+    //       reduced-resolution previews) get resampled to the recording size
+    auto &dst    = buffers[index].rgba;
+    auto &dstSize = settings.size;
+
+    if (size == dstSize) {
+      std::memcpy(dst.data(), pixels, dst.size() * sizeof(uint32_t));
+    } else {
+      for (int y = 0; y < dstSize.y; ++y) {
+        const auto *srcRow = pixels + size_t(y * size.y / dstSize.y) * size.x;
+        auto *dstRow = dst.data() + size_t(y) * dstSize.x;
+        for (int x = 0; x < dstSize.x; ++x)
+          dstRow[x] = srcRow[x * size.x / dstSize.x];
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      toEncode.push_back(index);
+    }
+
+    frameSubmitted.notify_one();
+    return true;
+  }
+
+  RecordingStats frame_recorder::stats() const
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    return counters;
+  }
+
+  void frame_recorder::encodeFrames()
+  {
+    while (true) {
+      int index = -1;
+
+      {
+        std::unique_lock<std::mutex> lock{mutex};
+        frameSubmitted.wait(lock, [&](){
+          return !toEncode.empty() || stopping;
+        });
+
+        if (toEncode.empty())
+          return;
+
+        index = toEncode.front();
+        toEncode.pop_front();
+      }
+
+      encode(buffers[index]);
+
+      {
+        std::lock_guard<std::mutex> lock{mutex};
+        toWrite[buffers[index].sequence] = index;
+      }
+
+      frameEncoded.notify_all();
+    }
+  }
+
+  bool frame_recorder::writeOutput(const uint8_t *data, size_t size)
+  {
+    while (size > 0) {
+      if (aborting)
+        return false;
+
+#ifdef _WIN32
+      auto n = _write(output, data, unsigned(std::min(size, size_t(1) << 30)));
+#else
+      auto n = write(output, data, size);
+      if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        pollfd ready {output, POLLOUT, 0};
+        poll(&ready, 1, 100);
+        continue;
+      }
+      if (n < 0 && errno == EINTR)
+        continue;
+#endif
+
+      if (n <= 0)
+        return false;
+
+      data += n;
+      size -= n;
+    }
+
+    return true;
+  }
+
+  void frame_recorder::writeFrames()
+  {
+    bool ok = true;
+
+    if (settings.format == RecordingFormat::Y4M) {
+      char header[128];
+      int n = snprintf(header, sizeof(header),
+                       "YUV4MPEG2 W%i H%i F%i:1 Ip A1:1 C420jpeg\n",
+                       settings.size.x, settings.size.y, settings.fps);
+      ok = writeOutput((const uint8_t*)header, n);
+    }
+
+    size_t nextToWrite = 0;
+
+    while (true) {
+      int index = -1;
+
+      {
+        std::unique_lock<std::mutex> lock{mutex};
+        frameEncoded.wait(lock, [&](){
+          return toWrite.count(nextToWrite) || aborting ||
+                 (stopping && nextToWrite == nextSequence);
+        });
+
+        auto next = toWrite.find(nextToWrite);
+        if (next == toWrite.end() || aborting)
+          break;
+
+        index = next->second;
+        toWrite.erase(next);
+      }
+
+      // NOTE: once the output failed, frames are only passed through
+      auto &encoded = buffers[index].encoded;
+      ok = ok && writeOutput(encoded.data(), encoded.size());
+
+      {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (ok)
+          counters.written++;
+        else
+          counters.failed = true;
+
+        freeBuffers.push_back(index);
+        nextToWrite++;
+      }
+
+      bufferFreed.notify_one();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      writerDone = true;
+    }
+
+    writerFinished.notify_all();
+  }
+
+  void frame_recorder::encode(Buffer &buffer) const
+  {
+    const int w = settings.size.x;
+    const int h = settings.size.y;
+
+    const auto *rgba = (const uint8_t*)buffer.rgba.data();
+    auto &out = buffer.encoded;
+
+    // NOTE: OSPRay frames are bottom-up, video frames top-down
+    auto srcRow = [&](int y) { return rgba + 4 * size_t(h - 1 - y) * w; };
+
+    if (settings.format == RecordingFormat::RGBA) {
+      out.resize(4 * size_t(w) * h);
+      for (int y = 0; y < h; ++y)
+        std::memcpy(out.data() + 4 * size_t(y) * w, srcRow(y), 4 * size_t(w));
+      return;
+    }
+
+    // BT.601 studio range, 8 bit fixed point
+    static const char frameHeader[] = "FRAME\n";
+    const size_t headerSize = sizeof(frameHeader) - 1;
+
+    const int cw = (w + 1) / 2;
+    const int ch = (h + 1) / 2;
+
+    out.resize(headerSize + size_t(w) * h + 2 * size_t(cw) * ch);
+    std::memcpy(out.data(), frameHeader, headerSize);
+
+    auto *yPlane = out.data() + headerSize;
+    auto *uPlane = yPlane + size_t(w) * h;
+    auto *vPlane = uPlane + size_t(cw) * ch;
+
+    for (int y = 0; y < h; ++y) {
+      const auto *in = srcRow(y);
+      auto *luma = yPlane + size_t(y) * w;
+      for (int x = 0; x < w; ++x) {
+        const int r = in[4 * x + 0], g = in[4 * x + 1], b = in[4 * x + 2];
+        luma[x] = uint8_t(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+      }
+    }
+
+    // NOTE: chroma gets averaged over each 2x2 block of pixels
+    for (int cy = 0; cy < ch; ++cy) {
+      const auto *row0 = srcRow(2 * cy);
+      const auto *row1 = srcRow(std::min(2 * cy + 1, h - 1));
+
+      for (int cx = 0; cx < cw; ++cx) {
+        const int x0 = 4 * (2 * cx);
+        const int x1 = 4 * std::min(2 * cx + 1, w - 1);
+
+        const int r = (row0[x0+0] + row0[x1+0] + row1[x0+0] + row1[x1+0]) / 4;
+        const int g = (row0[x0+1] + row0[x1+1] + row1[x0+1] + row1[x1+1]) / 4;
+        const int b = (row0[x0+2] + row0[x1+2] + row1[x0+2] + row1[x1+2]) / 4;
+
+        const size_t i = size_t(cy) * cw + cx;
+        uPlane[i] = uint8_t(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        vPlane[i] = uint8_t(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+      }
+    }
+  }
+
+}// namespace ospray
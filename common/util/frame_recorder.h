@@ -0,0 +1,142 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+// std
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ospcommon
+#include <ospcommon/vec.h>
+
+// ospImGui util
+#include "ImguiUtilExport.h"
+
+namespace ospray {
+
+  enum class RecordingFormat
+  {
+    Y4M,  // YUV4MPEG2 (4:2:0), understood by ffmpeg, x264, etc.
+    RGBA  // raw top-down RGBA8 frames
+  };
+
+  /*! what to do with a new frame when every buffer is still in flight;
+      BLOCK makes submit() wait, stalling whichever thread submits */
+  enum class RecordingPolicy {DROP, BLOCK};
+
+  struct RecordingSettings
+  {
+    std::string     path;                          // file or named pipe
+    RecordingFormat format     {RecordingFormat::Y4M};
+    RecordingPolicy policy     {RecordingPolicy::DROP};
+    ospcommon::vec2i size;                         // frames get resampled to it
+    int             fps        {30};
+    int             numBuffers {8};
+    int             numWorkers {2};
+  };
+
+  struct RecordingStats
+  {
+    size_t submitted {0};
+    size_t written   {0};
+    size_t dropped   {0}; // frames rejected because no buffer was free
+    size_t blocked   {0}; // submits which had to wait for a free buffer
+    bool   failed    {false};
+  };
+
+  /*! streams frames to a file or pipe with bounded memory.
+
+      submit() copies a frame into one of a fixed number of buffers, a
+      pool of workers converts the buffers to the output format in
+      parallel, and a single writer thread puts them out in submission
+      order. When all buffers are busy, new frames either get dropped or
+      wait for a free buffer, depending on the policy. */
+  class OSPRAY_IMGUI_UTIL_INTERFACE frame_recorder
+  {
+  public:
+
+    frame_recorder() = default;
+    ~frame_recorder();
+
+    /*! opens the output, returns false (and reports why) if it can't be;
+        a named pipe needs its reader to be running already */
+    bool start(const RecordingSettings &settings);
+    /*! finishes writing everything submitted so far, but gives up on an
+        output which doesn't take it within a few seconds */
+    void stop();
+
+    bool isRecording() const;
+
+    /*! RGBA8 pixels, bottom-up rows; returns false if the frame got dropped */
+    bool submit(const uint32_t *pixels, const ospcommon::vec2i &size);
+
+    RecordingStats stats() const;
+
+  private:
+
+    struct Buffer
+    {
+      size_t                sequence {0};
+      std::vector<uint32_t> rgba;
+      std::vector<uint8_t>  encoded;
+    };
+
+    void encodeFrames();
+    void writeFrames();
+
+    void encode(Buffer &buffer) const;
+
+    bool writeOutput(const uint8_t *data, size_t size);
+
+    // Data //
+
+    RecordingSettings settings;
+
+    mutable std::mutex mutex;
+    std::condition_variable bufferFreed;
+    std::condition_variable frameSubmitted;
+    std::condition_variable frameEncoded;
+    std::condition_variable writerFinished;
+
+    std::vector<Buffer>     buffers;
+    std::deque<int>         freeBuffers;
+    std::deque<int>         toEncode;
+    std::map<size_t, int>   toWrite;
+
+    size_t nextSequence {0};
+    bool   stopping     {false};
+    bool   writerDone   {false};
+
+    RecordingStats counters;
+
+    std::atomic<bool> recording {false};
+    std::atomic<bool> aborting  {false};
+
+    int output {-1};
+
+    std::vector<std::thread> encoders;
+    std::thread writer;
+  };
+
+}// namespace ospray
@@ -0,0 +1,186 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "frame_reprojector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <ospcommon/tasking/parallel_for.h>
+
+namespace ospray {
+
+  using namespace ospcommon;
+
+  static const uint64_t EMPTY_SAMPLE = std::numeric_limits<uint64_t>::max();
+  static const float    DEG_TO_RAD   = 3.14159265358979f / 180.f;
+
+  /*! the basis OSPRay's perspective camera generates its rays from */
+  struct CameraBasis
+  {
+    vec3f pos;
+    vec3f dir;
+    vec3f du;    // normalized screen x axis
+    vec3f dv;    // normalized screen y axis
+    float sizeX; // image plane extent at unit distance
+    float sizeY;
+    vec3f dir00; // ray direction through the lower left image corner
+  };
+
+  static CameraBasis basisOf(const PerspectiveView &view)
+  {
+    CameraBasis basis;
+    basis.pos   = view.pos;
+    basis.dir   = normalize(view.dir);
+    basis.du    = normalize(cross(basis.dir, view.up));
+    basis.dv    = cross(basis.du, basis.dir);
+    basis.sizeY = 2.f * std::tan(0.5f * view.fovy * DEG_TO_RAD);
+    basis.sizeX = basis.sizeY * view.aspect;
+    basis.dir00 = basis.dir - (0.5f * basis.sizeX) * basis.du
+                            - (0.5f * basis.sizeY) * basis.dv;
+    return basis;
+  }
+
+  static inline vec3f rayDirection(const CameraBasis &basis,
+                                    float sx, float sy)
+  {
+    return normalize(basis.dir00 +
+                     (sx * basis.sizeX) * basis.du +
+                     (sy * basis.sizeY) * basis.dv);
+  }
+
+  vec3f unprojectPixel(const PerspectiveView &view,
+                       const vec2f &screen,
+                       float depth)
+  {
+    const auto basis = basisOf(view);
+    return basis.pos + depth * rayDirection(basis, screen.x, screen.y);
+  }
+
+  static inline uint64_t packSample(float depth, uint32_t color)
+  {
+    uint32_t depthBits;
+    std::memcpy(&depthBits, &depth, sizeof(depthBits));
+    return (uint64_t(depthBits) << 32) | color;
+  }
+
+  static inline void atomicMin(std::atomic<uint64_t> &target, uint64_t value)
+  {
+    auto current = target.load(std::memory_order_relaxed);
+    while (value < current &&
+           !target.compare_exchange_weak(current, value,
+                                         std::memory_order_relaxed));
+  }
+
+  const std::vector<uint32_t> &
+  frame_reprojector::reproject(const vec2i &size,
+                               const uint32_t *color,
+                               const float *depth,
+                               const PerspectiveView &from,
+                               const PerspectiveView &to)
+  {
+    const size_t nPixels = size_t(size.x) * size.y;
+
+    if (numSamples != nPixels) {
+      samples.reset(new std::atomic<uint64_t>[nPixels]);
+      numSamples = nPixels;
+    }
+
+    result.resize(nPixels);
+
+    tasking::parallel_for(size.y, [&](int y) {
+      auto *row = &samples[size_t(y) * size.x];
+      for (int x = 0; x < size.x; ++x)
+        row[x].store(EMPTY_SAMPLE, std::memory_order_relaxed);
+    });
+
+    const auto src = basisOf(from);
+    const auto dst = basisOf(to);
+
+    // NOTE: geometry always wins over background, which sits at FLT_MAX
+    const float backgroundDepth = std::numeric_limits<float>::max();
+
+    tasking::parallel_for(size.y, [&](int y) {
+      const float sy = (y + 0.5f) / size.y;
+
+      for (int x = 0; x < size.x; ++x) {
+        const auto i  = size_t(y) * size.x + x;
+        const float sx = (x + 0.5f) / size.x;
+
+        const vec3f rayDir = rayDirection(src, sx, sy);
+
+        const float t = depth[i];
+
+        vec3f v;
+        float sampleDepth;
+
+        if (std::isfinite(t)) {
+          v = (src.pos + t * rayDir) - dst.pos;
+          sampleDepth = length(v);
+        } else {
+          v = rayDir;
+          sampleDepth = backgroundDepth;
+        }
+
+        const float z = dot(v, dst.dir);
+        if (z <= 0.f)
+          continue;
+
+        const float dx = 0.5f + dot(v, dst.du) / (z * dst.sizeX);
+        const float dy = 0.5f + dot(v, dst.dv) / (z * dst.sizeY);
+
+        const int px = int(std::floor(dx * size.x));
+        const int py = int(std::floor(dy * size.y));
+
+        if (px < 0 || py < 0 || px >= size.x || py >= size.y)
+          continue;
+
+        atomicMin(samples[size_t(py) * size.x + px],
+                  packSample(sampleDepth, color[i]));
+      }
+    });
+
+    // NOTE: forward splatting leaves single pixel cracks wherever the new
+    //       view magnifies the image, so fill those from the closest
+    //       neighbor that did receive a sample
+    tasking::parallel_for(size.y, [&](int y) {
+      for (int x = 0; x < size.x; ++x) {
+        const auto i = size_t(y) * size.x + x;
+        auto sample  = samples[i].load(std::memory_order_relaxed);
+
+        if (sample == EMPTY_SAMPLE) {
+          const int x0 = std::max(x - 1, 0), x1 = std::min(x + 1, size.x - 1);
+          const int y0 = std::max(y - 1, 0), y1 = std::min(y + 1, size.y - 1);
+
+          for (int ny = y0; ny <= y1; ++ny) {
+            for (int nx = x0; nx <= x1; ++nx) {
+              auto &neighbor = samples[size_t(ny) * size.x + nx];
+              sample = std::min(sample,
+                                neighbor.load(std::memory_order_relaxed));
+            }
+          }
+        }
+
+        result[i] = sample == EMPTY_SAMPLE ? 0u : uint32_t(sample);
+      }
+    });
+
+    return result;
+  }
+
+}// namespace ospray
@@ -0,0 +1,96 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// ospcommon
+#include <ospcommon/vec.h>
+
+// ospImGui util
+#include "ImguiUtilExport.h"
+
+namespace ospray {
+
+  /*! the parameters of an OSPRay perspective camera */
+  struct PerspectiveView
+  {
+    ospcommon::vec3f pos;
+    ospcommon::vec3f dir;
+    ospcommon::vec3f up;
+    float fovy   {60.f}; // in degrees
+    float aspect {1.f};
+  };
+
+  inline bool operator==(const PerspectiveView &a, const PerspectiveView &b)
+  {
+    return a.pos == b.pos && a.dir == b.dir && a.up == b.up &&
+           a.fovy == b.fovy && a.aspect == b.aspect;
+  }
+
+  inline bool operator!=(const PerspectiveView &a, const PerspectiveView &b)
+  {
+    return !(a == b);
+  }
+
+  /*! world space position seen at 'screen' (in [0,1]^2, origin at the lower
+      left) at the given OSP_FB_DEPTH value */
+  OSPRAY_IMGUI_UTIL_INTERFACE
+  ospcommon::vec3f unprojectPixel(const PerspectiveView &view,
+                                  const ospcommon::vec2f &screen,
+                                  float depth);
+
+  /*! forward-reprojects (warps) an image with per-pixel depth from the view
+      it was rendered with to a different one, so that there is something
+      sensible to show while the frame for the new view is still rendering.
+
+      Every source pixel is moved to where the new camera sees it, keeping
+      the closest one when several land on the same pixel; remaining holes
+      get filled from their neighbors. Pixels without a hit (infinite depth)
+      are treated as infinitely far away, i.e. only rotate with the camera. */
+  class OSPRAY_IMGUI_UTIL_INTERFACE frame_reprojector
+  {
+  public:
+
+    frame_reprojector()  = default;
+    ~frame_reprojector() = default;
+
+    /*! 'color' and 'depth' have size.x * size.y entries each, with depth
+        measured along each pixel's normalized camera ray like OSPRay's
+        OSP_FB_DEPTH channel; the result has the same size as the input and
+        stays valid until the next call */
+    const std::vector<uint32_t> &reproject(const ospcommon::vec2i &size,
+                                           const uint32_t *color,
+                                           const float *depth,
+                                           const PerspectiveView &from,
+                                           const PerspectiveView &to);
+
+  private:
+
+    // NOTE: each sample packs (depth bits << 32 | color), so an atomic min
+    //       keeps the closest color without any locking
+    std::unique_ptr<std::atomic<uint64_t>[]> samples;
+    size_t numSamples {0};
+
+    std::vector<uint32_t> result;
+  };
+
+}// namespace ospray
@@ -0,0 +1,133 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "latency_tracker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+
+namespace ospray {
+
+  double monotonicTime()
+  {
+    using namespace std::chrono;
+    auto now = steady_clock::now().time_since_epoch();
+    return duration_cast<duration<double>>(now).count();
+  }
+
+  double percentile(const std::vector<double> &sorted, double p)
+  {
+    auto rank = size_t(std::ceil(p * sorted.size()));
+    return sorted[std::min(std::max(rank, size_t(1)), sorted.size()) - 1];
+  }
+
+  static LatencyStats statsOf(std::vector<double> values)
+  {
+    LatencyStats stats;
+
+    if (values.empty())
+      return stats;
+
+    std::sort(values.begin(), values.end());
+
+    for (auto v : values)
+      stats.mean += v;
+
+    stats.mean /= values.size();
+    stats.p50   = percentile(values, 0.50);
+    stats.p95   = percentile(values, 0.95);
+    stats.p99   = percentile(values, 0.99);
+    stats.max   = values.back();
+
+    return stats;
+  }
+
+  void latency_tracker::inputScheduled(size_t generation, double inputTime)
+  {
+    pendingInputs.emplace_back(generation, inputTime);
+  }
+
+  void latency_tracker::frameDisplayed(size_t generation,
+                                       double commitTime,
+                                       double doneTime,
+                                       double displayTime)
+  {
+    // NOTE: generations only ever grow, so every input up to this frame's
+    //       generation is now on screen for the first time
+    while (!pendingInputs.empty() &&
+           pendingInputs.front().first <= generation) {
+      auto &input = pendingInputs.front();
+
+      LatencySample sample;
+      sample.generation    = input.first;
+      sample.inputToCommit = std::max(commitTime - input.second, 0.0);
+      sample.commitToDone  = doneTime - commitTime;
+      sample.doneToDisplay = displayTime - doneTime;
+      samples.push(sample);
+
+      pendingInputs.pop_front();
+    }
+  }
+
+  std::vector<LatencySample> latency_tracker::history() const
+  {
+    return samples.snapshot();
+  }
+
+  LatencySummary latency_tracker::summary() const
+  {
+    auto history = samples.snapshot();
+
+    std::vector<double> inputToCommit, commitToDone, doneToDisplay, total;
+    for (auto &s : history) {
+      inputToCommit.push_back(s.inputToCommit);
+      commitToDone.push_back(s.commitToDone);
+      doneToDisplay.push_back(s.doneToDisplay);
+      total.push_back(s.inputToCommit + s.commitToDone + s.doneToDisplay);
+    }
+
+    LatencySummary summary;
+    summary.numSamples    = history.size();
+    summary.inputToCommit = statsOf(std::move(inputToCommit));
+    summary.commitToDone  = statsOf(std::move(commitToDone));
+    summary.doneToDisplay = statsOf(std::move(doneToDisplay));
+    summary.total         = statsOf(std::move(total));
+
+    return summary;
+  }
+
+  bool latency_tracker::dumpCSV(const std::string &fileName) const
+  {
+    std::ofstream out(fileName);
+    if (!out.is_open())
+      return false;
+
+    out << "generation,input_to_commit_ms,commit_to_done_ms,"
+        << "done_to_display_ms" << std::endl;
+
+    for (auto &s : samples.snapshot()) {
+      out << s.generation             << ','
+          << s.inputToCommit * 1000.0 << ','
+          << s.commitToDone  * 1000.0 << ','
+          << s.doneToDisplay * 1000.0 << std::endl;
+    }
+
+    return true;
+  }
+
+}// namespace ospray
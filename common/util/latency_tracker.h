@@ -0,0 +1,96 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+// std
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ospImGui util
+#include "ImguiUtilExport.h"
+#include "ring_buffer.h"
+
+namespace ospray {
+
+  /*! seconds on a monotonic clock; use this for timestamps which get
+      compared across threads */
+  OSPRAY_IMGUI_UTIL_INTERFACE double monotonicTime();
+
+  /*! nearest-rank percentile ('p' in [0,1]) of a non-empty, already sorted
+      set of samples */
+  OSPRAY_IMGUI_UTIL_INTERFACE
+  double percentile(const std::vector<double> &sorted, double p);
+
+  /*! how long (in seconds) a single input took to reach the screen */
+  struct LatencySample
+  {
+    size_t generation    {0};
+    double inputToCommit {0.0}; // input event until its commit got applied
+    double commitToDone  {0.0}; // commit until a frame using it was finished
+    double doneToDisplay {0.0}; // finished frame until it was first shown
+  };
+
+  /*! distribution of one latency segment, in seconds */
+  struct LatencyStats
+  {
+    double mean {0.0};
+    double p50  {0.0};
+    double p95  {0.0};
+    double p99  {0.0};
+    double max  {0.0};
+  };
+
+  struct LatencySummary
+  {
+    size_t       numSamples {0};
+    LatencyStats inputToCommit;
+    LatencyStats commitToDone;
+    LatencyStats doneToDisplay;
+    LatencyStats total;
+  };
+
+  /*! matches input events, by the commit generation they were scheduled
+      with, against the first displayed frame rendered with that generation.
+      All members have to be called from the same (UI) thread. */
+  class OSPRAY_IMGUI_UTIL_INTERFACE latency_tracker
+  {
+  public:
+
+    latency_tracker()  = default;
+    ~latency_tracker() = default;
+
+    void inputScheduled(size_t generation, double inputTime);
+    void frameDisplayed(size_t generation,
+                        double commitTime,
+                        double doneTime,
+                        double displayTime);
+
+    std::vector<LatencySample> history() const;
+    LatencySummary summary() const;
+    bool dumpCSV(const std::string &fileName) const;
+
+  private:
+
+    static const size_t HISTORY_SIZE = 1024;
+
+    std::deque<std::pair<size_t, double>> pendingInputs;
+    ring_buffer<LatencySample, HISTORY_SIZE> samples;
+  };
+
+}// namespace ospray
@@ -0,0 +1,108 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "param_journal.h"
+
+#include <algorithm>
+
+namespace ospray {
+
+  void param_journal::record(OSPObject target, const std::string &name,
+                             int value)
+  {
+    auto &change = entryFor(target, name);
+    change.type  = ParamChange::Type::INT;
+    change.i     = value;
+  }
+
+  void param_journal::record(OSPObject target, const std::string &name,
+                             float value)
+  {
+    auto &change = entryFor(target, name);
+    change.type  = ParamChange::Type::FLOAT;
+    change.f     = value;
+  }
+
+  void param_journal::record(OSPObject target, const std::string &name,
+                             const ospcommon::vec3f &value)
+  {
+    auto &change = entryFor(target, name);
+    change.type  = ParamChange::Type::VEC3F;
+    change.v     = value;
+  }
+
+  void param_journal::record(OSPObject target, const std::string &name,
+                             OSPObject value)
+  {
+    auto &change  = entryFor(target, name);
+    change.type   = ParamChange::Type::OBJECT;
+    change.object = value;
+  }
+
+  bool param_journal::empty() const
+  {
+    return changes.empty();
+  }
+
+  size_t param_journal::size() const
+  {
+    return changes.size();
+  }
+
+  void param_journal::apply() const
+  {
+    for (auto &change : changes) {
+      auto *name = change.name.c_str();
+      switch (change.type) {
+      case ParamChange::Type::INT:
+        ospSet1i(change.target, name, change.i);
+        break;
+      case ParamChange::Type::FLOAT:
+        ospSet1f(change.target, name, change.f);
+        break;
+      case ParamChange::Type::VEC3F:
+        ospSet3f(change.target, name, change.v.x, change.v.y, change.v.z);
+        break;
+      case ParamChange::Type::OBJECT:
+        ospSetObject(change.target, name, change.object);
+        break;
+      }
+    }
+  }
+
+  void param_journal::clear()
+  {
+    changes.clear();
+  }
+
+  ParamChange &param_journal::entryFor(OSPObject target,
+                                       const std::string &name)
+  {
+    auto change = std::find_if(changes.begin(), changes.end(),
+                               [&](const ParamChange &c) {
+                                 return c.target == target && c.name == name;
+                               });
+
+    if (change != changes.end())
+      return *change;
+
+    changes.push_back(ParamChange());
+    changes.back().target = target;
+    changes.back().name   = name;
+    return changes.back();
+  }
+
+}// namespace ospray
@@ -0,0 +1,77 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+// std
+#include <string>
+#include <vector>
+
+// ospcommon
+#include <ospcommon/vec.h>
+
+// ospray
+#include <ospray/ospray.h>
+
+// ospImGui util
+#include "ImguiUtilExport.h"
+
+namespace ospray {
+
+  /*! a single typed parameter change for an OSPRay object */
+  struct ParamChange
+  {
+    enum class Type {INT, FLOAT, VEC3F, OBJECT};
+
+    OSPObject   target;
+    std::string name;
+    Type        type;
+
+    int              i;
+    float            f;
+    ospcommon::vec3f v;
+    OSPObject        object;
+  };
+
+  /*! ordered list of parameter changes which get set on their objects all
+      at once. Recording a parameter that is already in the journal only
+      replaces its value, so e.g. dragging a slider results in a single
+      change per batch. NOTE: this is not thread-safe on its own, users
+      have to provide their own synchronization. */
+  class OSPRAY_IMGUI_UTIL_INTERFACE param_journal
+  {
+  public:
+
+    void record(OSPObject target, const std::string &name, int value);
+    void record(OSPObject target, const std::string &name, float value);
+    void record(OSPObject target, const std::string &name,
+                const ospcommon::vec3f &value);
+    void record(OSPObject target, const std::string &name, OSPObject value);
+
+    bool   empty() const;
+    size_t size()  const;
+
+    void apply() const;
+    void clear();
+
+  private:
+
+    ParamChange &entryFor(OSPObject target, const std::string &name);
+
+    std::vector<ParamChange> changes;
+  };
+
+}// namespace ospray
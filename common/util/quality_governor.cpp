@@ -0,0 +1,136 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "quality_governor.h"
+
+#include <algorithm>
+
+namespace ospray {
+
+  // NOTE: frames have to be this much slower (faster) than the target to
+  //       lower (raise) the quality, and the measurement has to settle for
+  //       this many frames after each change before acting on it again
+  static const double SLOWER_THAN_TARGET     = 1.25;
+  static const double FASTER_THAN_TARGET     = 0.5;
+  static const int    FRAMES_BEFORE_LOWERING = 3;
+  static const int    FRAMES_BEFORE_RAISING  = 10;
+
+  static const double SMOOTHING = 0.3;
+
+  bool operator==(const QualitySettings &a, const QualitySettings &b)
+  {
+    return a.aoSamples    == b.aoSamples &&
+           a.spp          == b.spp       &&
+           a.shadows      == b.shadows   &&
+           a.previewScale == b.previewScale;
+  }
+
+  bool operator!=(const QualitySettings &a, const QualitySettings &b)
+  {
+    return !(a == b);
+  }
+
+  /*! each level gives up a little more quality than the one before it,
+      cheapest visual loss first */
+  static QualitySettings settingsForLevel(const QualitySettings &full,
+                                          int level)
+  {
+    auto s = full;
+
+    if (level >= 1) s.spp          = std::min(s.spp, 1);
+    if (level >= 2) s.aoSamples    = std::min(s.aoSamples, 1);
+    if (level >= 3) s.previewScale = std::max(s.previewScale, 2);
+    if (level >= 4) s.shadows      = false;
+    if (level >= 5) s.aoSamples    = 0;
+    if (level >= 6) s.previewScale = std::max(s.previewScale, 4);
+    if (level >= 7) s.previewScale = std::max(s.previewScale, 8);
+
+    return s;
+  }
+
+  void quality_governor::setFullQuality(const QualitySettings &settings)
+  {
+    fullQuality = settings;
+    resetMeasurement();
+  }
+
+  void quality_governor::setTargetFrameTime(double seconds)
+  {
+    target = std::max(seconds, 1e-3);
+    resetMeasurement();
+  }
+
+  double quality_governor::targetFrameTime() const
+  {
+    return target;
+  }
+
+  bool quality_governor::setInteracting(bool nowInteracting)
+  {
+    if (nowInteracting == interacting)
+      return false;
+
+    auto before = current();
+
+    interacting = nowInteracting;
+    resetMeasurement();
+
+    return current() != before;
+  }
+
+  bool quality_governor::update(double renderTime)
+  {
+    if (!interacting)
+      return false;
+
+    auto before = current();
+
+    smoothedTime = numSamples == 0 ? renderTime :
+        SMOOTHING * renderTime + (1.0 - SMOOTHING) * smoothedTime;
+    numSamples++;
+
+    if (numSamples >= FRAMES_BEFORE_LOWERING &&
+        smoothedTime > SLOWER_THAN_TARGET * target &&
+        interactiveLevel < MAX_LEVEL) {
+      interactiveLevel++;
+      resetMeasurement();
+    } else if (numSamples >= FRAMES_BEFORE_RAISING &&
+               smoothedTime < FASTER_THAN_TARGET * target &&
+               interactiveLevel > 0) {
+      interactiveLevel--;
+      resetMeasurement();
+    }
+
+    return current() != before;
+  }
+
+  QualitySettings quality_governor::current() const
+  {
+    return settingsForLevel(fullQuality, level());
+  }
+
+  int quality_governor::level() const
+  {
+    return interacting ? interactiveLevel : 0;
+  }
+
+  void quality_governor::resetMeasurement()
+  {
+    smoothedTime = 0.0;
+    numSamples   = 0;
+  }
+
+}// namespace ospray
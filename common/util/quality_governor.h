@@ -0,0 +1,86 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+// ospImGui util
+#include "ImguiUtilExport.h"
+
+namespace ospray {
+
+  /*! the renderer knobs the governor is allowed to turn */
+  struct QualitySettings
+  {
+    int  aoSamples    {1};
+    int  spp          {1};
+    bool shadows      {true};
+    int  previewScale {1};
+  };
+
+  OSPRAY_IMGUI_UTIL_INTERFACE
+  bool operator==(const QualitySettings &a, const QualitySettings &b);
+  OSPRAY_IMGUI_UTIL_INTERFACE
+  bool operator!=(const QualitySettings &a, const QualitySettings &b);
+
+  /*! closed-loop controller which trades rendering quality for frame time.
+
+      While the user interacts, the measured render times are compared
+      against a target frame time: quality drops one level as soon as
+      frames are clearly too slow and only comes back once they are clearly
+      fast enough, so it does not oscillate around the target. Once the
+      interaction ends, the full quality settings are restored (the level
+      reached is remembered for the next interaction). */
+  class OSPRAY_IMGUI_UTIL_INTERFACE quality_governor
+  {
+  public:
+
+    quality_governor()  = default;
+    ~quality_governor() = default;
+
+    void setFullQuality(const QualitySettings &settings);
+    void setTargetFrameTime(double seconds);
+
+    double targetFrameTime() const;
+
+    // Both return true if the settings to use changed //
+
+    bool setInteracting(bool interacting);
+    /*! feed the render time (in seconds) of a finished frame */
+    bool update(double renderTime);
+
+    QualitySettings current() const;
+    int level() const;
+
+    static const int MAX_LEVEL = 7;
+
+  private:
+
+    void resetMeasurement();
+
+    // Data //
+
+    QualitySettings fullQuality;
+
+    double target {1.0 / 20.0};
+
+    int  interactiveLevel {0};
+    bool interacting      {false};
+
+    double smoothedTime {0.0};
+    int    numSamples   {0};
+  };
+
+}// namespace ospray
@@ -0,0 +1,90 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+/*! Fixed-size history of the last SIZE values pushed by a single producer.
+
+    Pushing never blocks and simply overwrites the oldest value. Any other
+    thread can take a snapshot at any time: values that the producer may
+    have overwritten while they were being copied are dropped from the
+    snapshot instead of being returned torn. */
+template <typename T, size_t SIZE>
+class ring_buffer
+{
+public:
+
+  ring_buffer()  = default;
+  ~ring_buffer() = default;
+
+  // Producer side //
+
+  void push(const T &value);
+
+  // Any thread //
+
+  size_t count() const;
+  std::vector<T> snapshot() const;
+
+private:
+
+  T items[SIZE];
+  std::atomic<size_t> head {0};
+};
+
+// Inlined ring_buffer Members ////////////////////////////////////////////////
+
+template <typename T, size_t SIZE>
+inline void ring_buffer<T, SIZE>::push(const T &value)
+{
+  auto h = head.load(std::memory_order_relaxed);
+  items[h % SIZE] = value;
+  head.store(h + 1, std::memory_order_release);
+}
+
+template <typename T, size_t SIZE>
+inline size_t ring_buffer<T, SIZE>::count() const
+{
+  return head.load(std::memory_order_acquire);
+}
+
+template <typename T, size_t SIZE>
+inline std::vector<T> ring_buffer<T, SIZE>::snapshot() const
+{
+  auto end   = head.load(std::memory_order_acquire);
+  auto begin = end > SIZE ? end - SIZE : 0;
+
+  std::vector<T> values;
+  values.reserve(end - begin);
+
+  for (auto i = begin; i < end; ++i)
+    values.push_back(items[i % SIZE]);
+
+  // NOTE: anything at or below (newHead - SIZE) may have been overwritten
+  //       while we were copying it, so drop those from the front
+  std::atomic_thread_fence(std::memory_order_acquire);
+  auto newHead = head.load(std::memory_order_relaxed);
+  if (newHead >= begin + SIZE) {
+    auto numStale = std::min(newHead - SIZE + 1 - begin, values.size());
+    values.erase(values.begin(), values.begin() + numStale);
+  }
+
+  return values;
+}
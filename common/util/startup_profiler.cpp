@@ -0,0 +1,157 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "startup_profiler.h"
+#include "latency_tracker.h"
+
+namespace ospray {
+
+  // NOTE: initialized when the library is loaded, which is as close to the
+  //       start of the process as we can get
+  static const double processStart = monotonicTime();
+
+  static double sinceStart()
+  {
+    return monotonicTime() - processStart;
+  }
+
+  // startup_profiler definitions /////////////////////////////////////////////
+
+  startup_profiler &startup_profiler::instance()
+  {
+    static startup_profiler profiler;
+    return profiler;
+  }
+
+  void startup_profiler::begin(const std::string &phase)
+  {
+    auto now = sinceStart();
+
+    std::lock_guard<std::mutex> lock{mutex};
+    if (find(phase))
+      return;
+
+    Phase p;
+    p.name  = phase;
+    p.start = now;
+    phases.push_back(p);
+  }
+
+  void startup_profiler::end(const std::string &phase)
+  {
+    auto now = sinceStart();
+
+    std::lock_guard<std::mutex> lock{mutex};
+    auto *p = find(phase);
+    if (p && p->end < 0.0)
+      p->end = now;
+  }
+
+  void startup_profiler::mark(const std::string &event)
+  {
+    auto now = sinceStart();
+
+    std::lock_guard<std::mutex> lock{mutex};
+    if (find(event))
+      return;
+
+    Phase p;
+    p.name  = event;
+    p.start = now;
+    p.end   = now;
+    phases.push_back(p);
+  }
+
+  void startup_profiler::requestReport(ProfileFormat f, bool exitAfter)
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    reportRequested = true;
+    format          = f;
+    exitAfterReport = exitAfter;
+  }
+
+  void startup_profiler::report(FILE *out, ProfileFormat f) const
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+
+    if (f == ProfileFormat::JSON) {
+      fprintf(out, "{\n  \"phases\": [\n");
+      for (size_t i = 0; i < phases.size(); ++i) {
+        auto &p = phases[i];
+        fprintf(out, "    {\"name\": \"%s\", \"start_ms\": %f, "
+                "\"duration_ms\": %f}%s\n", p.name.c_str(), p.start * 1000.0,
+                p.end < 0.0 ? -1.0 : (p.end - p.start) * 1000.0,
+                i + 1 < phases.size() ? "," : "");
+      }
+      fprintf(out, "  ]\n}\n");
+    } else {
+      fprintf(out, "%-36s %12s %12s\n", "startup phase", "start ms",
+              "duration ms");
+      for (auto &p : phases) {
+        if (p.end < 0.0) {
+          fprintf(out, "%-36s %12.1f %12s\n", p.name.c_str(),
+                  p.start * 1000.0, "unfinished");
+        } else {
+          fprintf(out, "%-36s %12.1f %12.1f\n", p.name.c_str(),
+                  p.start * 1000.0, (p.end - p.start) * 1000.0);
+        }
+      }
+    }
+
+    fflush(out);
+  }
+
+  bool startup_profiler::finish()
+  {
+    ProfileFormat f;
+
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      if (!reportRequested || reported)
+        return false;
+
+      reported = true;
+      f        = format;
+    }
+
+    report(stdout, f);
+    return exitAfterReport;
+  }
+
+  startup_profiler::Phase *startup_profiler::find(const std::string &name)
+  {
+    for (auto &p : phases) {
+      if (p.name == name)
+        return &p;
+    }
+
+    return nullptr;
+  }
+
+  // scoped_startup_phase definitions /////////////////////////////////////////
+
+  scoped_startup_phase::scoped_startup_phase(const std::string &phase)
+    : phase(phase)
+  {
+    startup_profiler::instance().begin(phase);
+  }
+
+  scoped_startup_phase::~scoped_startup_phase()
+  {
+    startup_profiler::instance().end(phase);
+  }
+
+}// namespace ospray
@@ -0,0 +1,93 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+// std
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// ospImGui util
+#include "ImguiUtilExport.h"
+
+namespace ospray {
+
+  enum class ProfileFormat {TABLE, JSON};
+
+  /*! records how long each phase of getting the first frame on screen took,
+      relative to when the process started.
+
+      Only the first occurrence of a phase counts: beginning a phase that
+      was already begun (and ending one that already ended) is ignored, so
+      code that runs again later (e.g. an engine restart) can stay as is. */
+  class OSPRAY_IMGUI_UTIL_INTERFACE startup_profiler
+  {
+  public:
+
+    static startup_profiler &instance();
+
+    void begin(const std::string &phase);
+    void end(const std::string &phase);
+
+    /*! a phase without duration, e.g. the first frame being displayed */
+    void mark(const std::string &event);
+
+    void requestReport(ProfileFormat format, bool exitAfterReport);
+
+    void report(FILE *out, ProfileFormat format) const;
+
+    /*! print the requested report (once); returns true if the application
+        was asked to exit afterwards */
+    bool finish();
+
+  private:
+
+    startup_profiler() = default;
+
+    struct Phase
+    {
+      std::string name;
+      double start {0.0}; // seconds since the process started
+      double end   {-1.0};
+    };
+
+    Phase *find(const std::string &name);
+
+    // Data //
+
+    mutable std::mutex mutex;
+    std::vector<Phase> phases;
+
+    bool          reportRequested {false};
+    bool          reported {false};
+    ProfileFormat format {ProfileFormat::TABLE};
+    bool          exitAfterReport {false};
+  };
+
+  /*! begins a startup phase when created and ends it when destroyed */
+  struct OSPRAY_IMGUI_UTIL_INTERFACE scoped_startup_phase
+  {
+    scoped_startup_phase(const std::string &phase);
+    ~scoped_startup_phase();
+
+  private:
+
+    std::string phase;
+  };
+
+}// namespace ospray
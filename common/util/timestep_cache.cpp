@@ -0,0 +1,145 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "timestep_cache.h"
+
+#include <algorithm>
+
+namespace ospray {
+
+  timestep_cache::timestep_cache(size_t numTimesteps,
+                                 LoadFcn load,
+                                 size_t budgetBytes)
+    : numTimesteps(numTimesteps),
+      load(std::move(load)),
+      budgetBytes(budgetBytes)
+  {
+  }
+
+  timestep_cache::~timestep_cache()
+  {
+    for (auto &r : resident)
+      ospRelease(r.second.model.object());
+  }
+
+  size_t timestep_cache::size() const
+  {
+    return numTimesteps;
+  }
+
+  cpp::Model timestep_cache::acquire(size_t timestep)
+  {
+    std::unique_lock<std::mutex> lock{mutex};
+
+    // NOTE: a timestep is never loaded twice, concurrent callers wanting one
+    //       that is already being loaded wait for that load to finish
+    loadFinished.wait(lock, [&](){ return !loading.count(timestep); });
+
+    auto r = resident.find(timestep);
+    if (r != resident.end()) {
+      lru.splice(lru.begin(), lru, r->second.lruPos);
+      return r->second.model;
+    }
+
+    loading.insert(timestep);
+
+    lock.unlock();
+    Entry entry;
+    entry.model = load(timestep, entry.bytes, entry.keepAlive);
+    lock.lock();
+
+    loading.erase(timestep);
+    loads++;
+
+    if (entry.model.handle()) {
+      lru.push_front(timestep);
+      entry.lruPos = lru.begin();
+      bytesUsed   += entry.bytes;
+
+      resident.emplace(timestep, entry);
+
+      evict();
+    }
+
+    lock.unlock();
+    loadFinished.notify_all();
+
+    return entry.model;
+  }
+
+  void timestep_cache::setBudget(size_t bytes)
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    budgetBytes = bytes;
+    evict();
+  }
+
+  size_t timestep_cache::budget() const
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    return budgetBytes;
+  }
+
+  void timestep_cache::setMinResident(size_t n)
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    minResident = std::max(n, size_t(1));
+    evict();
+  }
+
+  size_t timestep_cache::residentBytes() const
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    return bytesUsed;
+  }
+
+  size_t timestep_cache::numResident() const
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    return resident.size();
+  }
+
+  size_t timestep_cache::numLoads() const
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    return loads;
+  }
+
+  size_t timestep_cache::numEvictions() const
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    return evictions;
+  }
+
+  void timestep_cache::evict()
+  {
+    while (bytesUsed > budgetBytes && lru.size() > minResident) {
+      auto timestep = lru.back();
+      lru.pop_back();
+
+      auto r = resident.find(timestep);
+      bytesUsed -= r->second.bytes;
+
+      // NOTE: what the model's arrays live in goes away with the entry, the
+      //       renderer only ever holds one of the 'minResident' timesteps
+      ospRelease(r->second.model.object());
+      resident.erase(r);
+
+      evictions++;
+    }
+  }
+
+}// namespace ospray
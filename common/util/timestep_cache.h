@@ -0,0 +1,107 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+// std
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+
+// ospray::cpp
+#include <ospray/ospray_cpp/Model.h>
+
+// ospImGui util
+#include "ImguiUtilExport.h"
+
+namespace ospray {
+
+  /*! loads animation timesteps on demand and keeps the recently used ones
+      resident, within a memory budget.
+
+      Least recently used timesteps are released once the resident models
+      exceed the budget, but the 'minResident' most recently used ones are
+      always kept: those may still be handed to the renderer. Loading
+      happens inside acquire(), on the calling thread, but without holding
+      the lock: other callers (e.g. the GUI reading statistics) are only
+      blocked when they want the very timestep being loaded. */
+  class OSPRAY_IMGUI_UTIL_INTERFACE timestep_cache
+  {
+  public:
+
+    /*! load (and commit) a timestep, reporting the memory it takes and
+        anything the model's arrays live in (e.g. a mapped file), which is
+        kept until the timestep is evicted; an invalid model means the
+        timestep failed to load */
+    using LoadFcn =
+        std::function<cpp::Model(size_t timestep, size_t &bytes,
+                                 std::shared_ptr<const void> &keepAlive)>;
+
+    timestep_cache(size_t numTimesteps, LoadFcn load, size_t budgetBytes);
+    ~timestep_cache();
+
+    size_t size() const;
+
+    cpp::Model acquire(size_t timestep);
+
+    void   setBudget(size_t bytes);
+    size_t budget() const;
+
+    void setMinResident(size_t n);
+
+    // Statistics //
+
+    size_t residentBytes() const;
+    size_t numResident() const;
+    size_t numLoads() const;
+    size_t numEvictions() const;
+
+  private:
+
+    void evict();
+
+    struct Entry
+    {
+      cpp::Model model {nullptr};
+      size_t     bytes {0};
+      std::shared_ptr<const void> keepAlive;
+      std::list<size_t>::iterator lruPos;
+    };
+
+    // Data //
+
+    size_t  numTimesteps;
+    LoadFcn load;
+
+    mutable std::mutex mutex;
+    std::condition_variable loadFinished;
+
+    std::map<size_t, Entry> resident;
+    std::set<size_t> loading;
+    std::list<size_t> lru; // most recently used first
+
+    size_t budgetBytes;
+    size_t minResident {1};
+    size_t bytesUsed {0};
+    size_t loads {0};
+    size_t evictions {0};
+  };
+
+}// namespace ospray
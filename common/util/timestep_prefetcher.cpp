@@ -0,0 +1,139 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "timestep_prefetcher.h"
+
+#include <algorithm>
+
+namespace ospray {
+
+  timestep_prefetcher::~timestep_prefetcher()
+  {
+    stop();
+  }
+
+  void timestep_prefetcher::start(PrepareFcn fcn)
+  {
+    stop();
+
+    prepare = std::move(fcn);
+    quit    = false;
+    worker  = std::thread([&](){ run(); });
+  }
+
+  void timestep_prefetcher::stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      quit = true;
+    }
+
+    workAvailable.notify_one();
+
+    if (worker.joinable())
+      worker.join();
+
+    pending.clear();
+    wanted.clear();
+    prepared.clear();
+  }
+
+  bool timestep_prefetcher::isRunning() const
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    return !quit;
+  }
+
+  void timestep_prefetcher::request(const std::vector<size_t> &timesteps)
+  {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+
+      if (timesteps == wanted)
+        return;
+
+      wanted = timesteps;
+
+      auto isWanted = [&](size_t t) {
+        return std::find(wanted.begin(), wanted.end(), t) != wanted.end();
+      };
+
+      for (auto p = prepared.begin(); p != prepared.end();) {
+        if (isWanted(p->first))
+          ++p;
+        else
+          p = prepared.erase(p);
+      }
+
+      pending.clear();
+      for (auto t : wanted) {
+        if (!prepared.count(t))
+          pending.push_back(t);
+      }
+    }
+
+    workAvailable.notify_one();
+  }
+
+  bool timestep_prefetcher::fetch(size_t timestep, cpp::Model &model) const
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto p = prepared.find(timestep);
+    if (p == prepared.end())
+      return false;
+
+    model = p->second;
+    return true;
+  }
+
+  void timestep_prefetcher::clear()
+  {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      prepared.clear();
+      pending.assign(wanted.begin(), wanted.end());
+    }
+
+    workAvailable.notify_one();
+  }
+
+  void timestep_prefetcher::run()
+  {
+    std::unique_lock<std::mutex> lock{mutex};
+
+    while (true) {
+      workAvailable.wait(lock, [&](){ return quit || !pending.empty(); });
+
+      if (quit)
+        break;
+
+      auto timestep = pending.front();
+      pending.pop_front();
+
+      // NOTE: prepare without holding the lock, requests made meanwhile may
+      //       no longer want this timestep by the time it is done
+      lock.unlock();
+      auto model = prepare(timestep);
+      lock.lock();
+
+      // NOTE: operator[] would default construct (and so create) a model
+      if (std::find(wanted.begin(), wanted.end(), timestep) != wanted.end())
+        prepared.emplace(timestep, model);
+    }
+  }
+
+}// namespace ospray
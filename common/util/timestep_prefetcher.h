@@ -0,0 +1,82 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+// std
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ospray::cpp
+#include <ospray/ospray_cpp/Model.h>
+
+// ospImGui util
+#include "ImguiUtilExport.h"
+
+namespace ospray {
+
+  /*! prepares (builds and commits) animation timestep models on a worker
+      thread ahead of the timestep being shown.
+
+      Only the most recently requested timesteps are kept: a new request
+      drops any prepared models and pending work not part of it. */
+  class OSPRAY_IMGUI_UTIL_INTERFACE timestep_prefetcher
+  {
+  public:
+
+    using PrepareFcn = std::function<cpp::Model(size_t timestep)>;
+
+    timestep_prefetcher()  = default;
+    ~timestep_prefetcher();
+
+    void start(PrepareFcn prepare);
+    void stop();
+
+    bool isRunning() const;
+
+    /*! timesteps to prepare, in the order they will be needed */
+    void request(const std::vector<size_t> &timesteps);
+
+    /*! get a prepared timestep, returns false if it isn't ready yet */
+    bool fetch(size_t timestep, cpp::Model &model) const;
+
+    /*! drop everything prepared so far, e.g. after the models changed */
+    void clear();
+
+  private:
+
+    void run();
+
+    // Data //
+
+    PrepareFcn prepare;
+
+    mutable std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::deque<size_t> pending;
+    std::vector<size_t> wanted;
+    std::map<size_t, cpp::Model> prepared;
+    bool quit {true};
+
+    std::thread worker;
+  };
+
+}// namespace ospray
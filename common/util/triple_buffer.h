@@ -0,0 +1,96 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include <atomic>
+
+/*! Single-producer/single-consumer triple buffer.
+
+    The producer always owns a 'back' slot it can write into, the consumer
+    always owns a 'front' slot it can read from, and the third ('middle')
+    slot holds the most recently published value. Publishing and acquiring
+    are a single atomic exchange each, so neither side ever waits on the
+    other and the consumer always sees the newest published value. */
+template <typename T>
+class triple_buffer
+{
+public:
+
+  triple_buffer()  = default;
+  ~triple_buffer() = default;
+
+  // Producer side //
+
+  T &back();
+  void publish();
+
+  // Consumer side //
+
+  bool hasNew() const;
+  bool update();
+  T &front();
+
+private:
+
+  static const int NEW_BIT    = 0x4;
+  static const int INDEX_MASK = 0x3;
+
+  T buffers[3];
+
+  int backIndex  {0};
+  int frontIndex {1};
+  std::atomic<int> middleIndex {2};
+};
+
+// Inlined triple_buffer Members //////////////////////////////////////////////
+
+template <typename T>
+inline T &triple_buffer<T>::back()
+{
+  return buffers[backIndex];
+}
+
+template <typename T>
+inline void triple_buffer<T>::publish()
+{
+  auto old  = middleIndex.exchange(backIndex | NEW_BIT,
+                                   std::memory_order_acq_rel);
+  backIndex = old & INDEX_MASK;
+}
+
+template <typename T>
+inline bool triple_buffer<T>::hasNew() const
+{
+  return middleIndex.load(std::memory_order_acquire) & NEW_BIT;
+}
+
+template <typename T>
+inline bool triple_buffer<T>::update()
+{
+  if (!hasNew())
+    return false;
+
+  auto old   = middleIndex.exchange(frontIndex, std::memory_order_acq_rel);
+  frontIndex = old & INDEX_MASK;
+  return true;
+}
+
+template <typename T>
+inline T &triple_buffer<T>::front()
+{
+  return buffers[frontIndex];
+}
@@ -18,12 +18,67 @@
 #include "common/commandline/Utility.h"
 
 #include "widgets/imguiViewer.h"
+#include "common/util/latency_tracker.h"
+#include "sceneCache.h"
+#include "sceneLoader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
 
 ospcommon::vec3f translate;
 ospcommon::vec3f scale;
 bool lockFirstFrame = false;
 bool showGui = true;
 
+std::string startupProfile; // "table" or "json", empty for no report
+bool exitAfterStartup = false;
+
+bool benchmark = false;
+int benchmarkWarmupFrames = 10;
+int benchmarkFrames = 100;
+
+std::string replayPathFile;
+int replayFramesPerKeyframe = 1;
+
+std::vector<std::string> sceneFiles;
+std::vector<std::string> timestepFiles;
+size_t timestepBudgetMB = 0;
+
+// pull the files we load ourselves out of the command line before the
+// default parsers see them: '--timesteps <budgetMB> <file> [<file> ...]' and,
+// with '--parallel-load' or '--scene-cache <dir>', any OBJ/PLY/STL files,
+// which then get loaded in parallel and through the scene cache
+//
+// NOTE: our loader keeps geometry and numeric material parameters only (no
+//       textures), so the default parsers stay the default
+void extractSceneFiles(int &ac, const char **av)
+{
+  bool ownLoader = false;
+  for (int i = 1; i < ac; i++) {
+    const std::string arg = av[i];
+    if (arg == "--parallel-load" || arg == "--scene-cache")
+      ownLoader = true;
+  }
+
+  int dst = 1;
+  for (int i = 1; i < ac; i++) {
+    const std::string arg = av[i];
+    if (arg == "--parallel-load") {
+      continue;
+    } else if (arg == "--timesteps" && i + 1 < ac) {
+      timestepBudgetMB = std::max(atoi(av[++i]), 0);
+      while (i + 1 < ac && av[i + 1][0] != '-')
+        timestepFiles.push_back(av[++i]);
+    } else if (ownLoader && ospray::isSceneFile(arg)) {
+      sceneFiles.push_back(arg);
+    } else {
+      av[dst++] = av[i];
+    }
+  }
+  ac = dst;
+}
+
 void parseExtraParametersFromComandLine(int ac, const char **&av)
 {
   for (int i = 1; i < ac; i++) {
@@ -40,33 +95,343 @@ void parseExtraParametersFromComandLine(int ac, const char **&av)
       lockFirstFrame = true;
     } else if (arg == "--nogui") {
       showGui = false;
+    } else if (arg == "--benchmark") {
+      benchmark = true;
+      benchmarkWarmupFrames = std::max(atoi(av[++i]), 0);
+      benchmarkFrames = std::max(atoi(av[++i]), 1);
+    } else if (arg == "--startup-profile") {
+      startupProfile = av[++i];
+    } else if (arg == "--exit-after-startup") {
+      exitAfterStartup = true;
+    } else if (arg == "--scene-cache") {
+      ospray::setSceneCacheDirectory(av[++i]);
+    } else if (arg == "--replay-camera-path") {
+      replayPathFile = av[++i];
+      replayFramesPerKeyframe = std::max(atoi(av[++i]), 1);
     }
   }
+
+  if (!startupProfile.empty()) {
+    ospray::startup_profiler::instance().requestReport(
+        startupProfile == "json" ? ospray::ProfileFormat::JSON
+                                 : ospray::ProfileFormat::TABLE,
+        exitAfterStartup);
+  }
+}
+
+// render a fixed number of frames without opening a window and report
+// frame time statistics as JSON on stdout
+int runBenchmark(const std::deque<ospcommon::box3f> &bbox,
+                 const std::deque<ospray::cpp::Model> &model,
+                 ospray::cpp::Renderer renderer,
+                 ospray::cpp::Camera camera)
+{
+  using namespace ospcommon;
+  using ospray::imgui3D::ImGui3DWidget;
+
+  ImGui3DWidget::ViewPort viewPort;
+  if (!ospray::imgui3D::commandLineViewPort(viewPort) && !bbox.empty()) {
+    // same default view ImGui3DWidget::setWorldBounds() would pick
+    vec3f center  = ospcommon::center(bbox[0]);
+    vec3f diag    = bbox[0].size();
+    diag          = max(diag, vec3f(0.3f*length(diag)));
+    viewPort.at   = center;
+    viewPort.from = center - .75f*vec3f(-.6*diag.x,-1.2f*diag.y,.8f*diag.z);
+  }
+
+  if (length(viewPort.up) < 1e-3f)
+    viewPort.up = vec3f(0,0,1.f);
+
+  const vec2i size = ImGui3DWidget::defaultInitSize;
+
+  camera.set("pos", viewPort.from);
+  camera.set("dir", viewPort.at - viewPort.from);
+  camera.set("up", viewPort.up);
+  camera.set("aspect", size.x / float(size.y));
+  camera.set("fovy", viewPort.openingAngle);
+  camera.commit();
+
+  renderer.set("model",  model[0]);
+  renderer.set("camera", camera);
+
+  ospray::async_render_engine engine;
+  engine.setRenderer(renderer);
+  engine.setFbSize(size);
+  engine.scheduleObjectCommit(renderer);
+  engine.start();
+
+  // NOTE: the timing history holds every rendered frame in order, so poll it
+  //       instead of the published frames (which may skip some)
+  std::vector<double> frameTimes;
+  size_t lastSeenFrame = 0;
+
+  while (frameTimes.size() < size_t(benchmarkFrames)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    for (auto &t : engine.timingHistory()) {
+      if (t.frameId <= lastSeenFrame)
+        continue;
+
+      lastSeenFrame = t.frameId;
+
+      if (t.frameId > size_t(benchmarkWarmupFrames) &&
+          frameTimes.size() < size_t(benchmarkFrames)) {
+        frameTimes.push_back(t.commit + t.resize + t.render +
+                             t.map + t.copy + t.publish);
+      }
+    }
+  }
+
+  engine.stop();
+
+  std::sort(frameTimes.begin(), frameTimes.end());
+
+  double sum = 0.0;
+  for (auto t : frameTimes)
+    sum += t;
+
+  const auto n      = frameTimes.size();
+  const auto mean   = sum / n;
+  const auto median = n % 2 ? frameTimes[n/2]
+                            : 0.5 * (frameTimes[n/2 - 1] + frameTimes[n/2]);
+
+  printf("{\n");
+  printf("  \"width\": %i,\n", size.x);
+  printf("  \"height\": %i,\n", size.y);
+  printf("  \"warmup_frames\": %i,\n", benchmarkWarmupFrames);
+  printf("  \"frames\": %i,\n", int(n));
+  printf("  \"mean_ms\": %f,\n", mean * 1000.0);
+  printf("  \"median_ms\": %f,\n", median * 1000.0);
+  printf("  \"p95_ms\": %f,\n",
+         ospray::percentile(frameTimes, 0.95) * 1000.0);
+  printf("  \"p99_ms\": %f,\n",
+         ospray::percentile(frameTimes, 0.99) * 1000.0);
+  printf("  \"min_ms\": %f,\n", frameTimes.front() * 1000.0);
+  printf("  \"max_ms\": %f,\n", frameTimes.back() * 1000.0);
+  printf("  \"fps\": %f\n", 1.0 / mean);
+  printf("}\n");
+  fflush(stdout);
+
+  return 0;
+}
+
+// render every keyframe of a recorded camera path to a fixed number of
+// accumulated frames without opening a window, reporting the time each
+// keyframe took as JSON on stdout
+int runCameraPathReplay(const std::deque<ospray::cpp::Model> &model,
+                        ospray::cpp::Renderer renderer,
+                        ospray::cpp::Camera camera)
+{
+  using namespace ospcommon;
+  using ospray::imgui3D::ImGui3DWidget;
+
+  ospray::camera_path path;
+  if (!path.load(replayPathFile)) {
+    std::cerr << "failed to read camera path '" << replayPathFile << "'"
+              << std::endl;
+    return 1;
+  }
+
+  const vec2i size = ImGui3DWidget::defaultInitSize;
+
+  renderer.set("model",  model[0]);
+  renderer.set("camera", camera);
+  renderer.commit();
+
+  // NOTE: render synchronously, so each keyframe's time is exactly the time
+  //       spent committing its camera and rendering its frames
+  ospray::cpp::FrameBuffer frameBuffer(osp::vec2i{size.x, size.y},
+                                       OSP_FB_SRGBA,
+                                       OSP_FB_COLOR | OSP_FB_ACCUM);
+
+  std::vector<double> keyframeTimes;
+
+  for (size_t i = 0; i < path.size(); ++i) {
+    auto &keyframe = path[i];
+    auto start     = getSysTime();
+
+    camera.set("pos", keyframe.from);
+    camera.set("dir", keyframe.at - keyframe.from);
+    camera.set("up", keyframe.up);
+    camera.set("aspect", size.x / float(size.y));
+    camera.set("fovy", keyframe.fovy);
+    camera.commit();
+
+    frameBuffer.clear(OSP_FB_COLOR | OSP_FB_ACCUM);
+
+    for (int f = 0; f < replayFramesPerKeyframe; ++f)
+      renderer.renderFrame(frameBuffer, OSP_FB_COLOR | OSP_FB_ACCUM);
+
+    keyframeTimes.push_back(getSysTime() - start);
+  }
+
+  ospray::printReplayReport(stdout, path, keyframeTimes,
+                            replayFramesPerKeyframe);
+
+  return 0;
 }
 
 int main(int ac, const char **av)
 {
-  ospInit(&ac,av);
+  using ospray::scoped_startup_phase;
 
-  ospray::imgui3D::init(&ac,av);
+  {
+    scoped_startup_phase phase("ospInit");
+    ospInit(&ac,av);
+  }
 
-  auto ospObjs = parseWithDefaultParsers(ac, av);
+  {
+    scoped_startup_phase phase("imgui3D::init");
+    ospray::imgui3D::init(&ac,av);
+  }
+
+  extractSceneFiles(ac, av);
+
+  // NOTE: scene cache files shared with OSPRay stay mapped until exit
+  std::vector<std::shared_ptr<const void>> sceneMappings;
 
   std::deque<ospcommon::box3f>   bbox;
   std::deque<ospray::cpp::Model> model;
   ospray::cpp::Renderer renderer;
   ospray::cpp::Camera   camera;
 
-  std::tie(bbox, model, renderer, camera) = ospObjs;
+  {
+    scoped_startup_phase phase("parseWithDefaultParsers");
+    std::tie(bbox, model, renderer, camera) =
+        parseWithDefaultParsers(ac, av);
+  }
 
   parseExtraParametersFromComandLine(ac, av);
+
+  if (!sceneFiles.empty()) {
+    scoped_startup_phase phase("load scene files");
+
+    ospcommon::box3f sceneBounds;
+    auto scene = ospray::loadSceneFiles(sceneFiles, renderer, sceneBounds,
+                                        sceneMappings);
+    if (!scene.handle())
+      return 1;
+
+    // NOTE: anything the default parsers loaded stays part of the scene
+    if (model.empty()) {
+      model = {scene};
+      bbox  = {sceneBounds};
+    } else {
+      ospcommon::affine3f xfm = ospcommon::one;
+      OSPGeometry inst = ospNewInstance((OSPModel)scene.object(),
+                                        (osp::affine3f&)xfm);
+      model[0].addGeometry(inst);
+      model[0].commit();
+      ospRelease(inst);
+
+      if (bbox.empty())
+        bbox = {sceneBounds};
+      else if (!bbox[0].empty())
+        bbox[0].extend(sceneBounds);
+      else
+        bbox[0] = sceneBounds;
+    }
+  }
+
+  // NOTE: when streaming, only the first timestep is loaded before the
+  //       window opens; the viewer loads the rest as playback needs them
+  std::shared_ptr<ospray::timestep_cache> timesteps;
+  std::vector<ospcommon::box3f> timestepBounds(timestepFiles.size());
+
+  if (!timestepFiles.empty()) {
+    // NOTE: a scene loaded from the rest of the command line stays in view,
+    //       every timestep is shown next to it
+    ospray::cpp::Model staticScene(nullptr);
+    ospcommon::box3f   staticBounds;
+    if (!model.empty() && !bbox.empty() && !bbox[0].empty()) {
+      staticScene  = model[0];
+      staticBounds = bbox[0];
+
+      if (model.size() > 1) {
+        std::cerr << "only the first of " << model.size() << " models is "
+                  << "shown together with the streamed timesteps"
+                  << std::endl;
+      }
+    }
+
+    // NOTE: the cache calls this from the prefetch worker long after this
+    //       block is left, so the static scene is captured by value
+    auto loadTimestep = [&, staticScene, staticBounds](
+        size_t t, size_t &bytes, std::shared_ptr<const void> &keepAlive) {
+      ospray::ParsedScene scene;
+      if (!ospray::loadSceneFile(timestepFiles[t], scene))
+        return ospray::cpp::Model(nullptr);
+
+      bytes     = scene.bytes();
+      keepAlive = scene.mapping;
+      timestepBounds[t] = scene.bounds;
+      auto timestep = ospray::createModel(scene, renderer);
+
+      if (!staticScene.handle())
+        return timestep;
+
+      timestepBounds[t].extend(staticBounds);
+
+      ospcommon::affine3f xfm = ospcommon::one;
+      OSPGeometry staticInst = ospNewInstance((OSPModel)staticScene.object(),
+                                              (osp::affine3f&)xfm);
+      OSPGeometry dynInst = ospNewInstance((OSPModel)timestep.object(),
+                                           (osp::affine3f&)xfm);
+
+      ospray::cpp::Model world;
+      world.addGeometry(staticInst);
+      world.addGeometry(dynInst);
+      world.commit();
+
+      // NOTE: the world model keeps the instances (and so the timestep)
+      //       alive until the cache releases it
+      ospRelease(staticInst);
+      ospRelease(dynInst);
+      ospRelease(timestep.object());
+
+      return world;
+    };
+
+    timesteps = std::make_shared<ospray::timestep_cache>(
+        timestepFiles.size(), loadTimestep, timestepBudgetMB << 20);
+
+    ospray::startup_profiler::instance().begin("load first timestep");
+    auto first = timesteps->acquire(0);
+    ospray::startup_profiler::instance().end("load first timestep");
+
+    if (!first.handle())
+      return 1;
+
+    model = {first};
+    bbox  = {timestepBounds[0]};
+
+    if (lockFirstFrame) {
+      std::cerr << "--lockFirstFrame is ignored for streamed timesteps"
+                << std::endl;
+      lockFirstFrame = false;
+    }
+  }
+
+  if (benchmark)
+    return runBenchmark(bbox, model, renderer, camera);
+
+  if (!replayPathFile.empty())
+    return runCameraPathReplay(model, renderer, camera);
+
   ospray::imgui3D::ImGui3DWidget::showGui = showGui;
 
+  ospray::startup_profiler::instance().begin("ImGuiViewer constructor");
   ospray::ImGuiViewer window(bbox, model, renderer, camera);
   window.setScale(scale);
   window.setLockFirstAnimationFrame(lockFirstFrame);
   window.setTranslation(translate);
-  window.create("ospImGui: OSPRay ImGui Viewer App");
+  window.setTimestepCache(timesteps);
+  ospray::startup_profiler::instance().end("ImGuiViewer constructor");
+
+  {
+    scoped_startup_phase phase("ImGui3DWidget::create");
+    window.create("ospImGui: OSPRay ImGui Viewer App");
+  }
 
   ospray::imgui3D::run();
 }
@@ -0,0 +1,463 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "sceneCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+using namespace ospcommon;
+
+namespace ospray {
+
+  // NOTE: a cache file is a header, the source path, one MeshEntry per
+  //       mesh, and then the arrays (each starting on an ARRAY_ALIGNMENT
+  //       boundary) and the serialized materials the entries point at
+
+  static const char     cacheMagic[8] = {'O','S','P','S','C','A','C','H'};
+  static const uint32_t cacheVersion  = 1;
+  static const uint64_t ARRAY_ALIGNMENT = 64;
+
+  enum {POSITIONS, NORMALS, COLORS, INDICES, NUM_ARRAYS};
+
+  struct CacheHeader
+  {
+    char     magic[8];
+    uint32_t version;
+    uint32_t numMeshes;
+    uint64_t sourceSize;
+    int64_t  sourceMTime;
+    uint64_t pathLength;
+    float    bounds[6];
+  };
+
+  struct MeshEntry
+  {
+    uint64_t count[NUM_ARRAYS];
+    uint64_t offset[NUM_ARRAYS];
+    uint64_t materialOffset; // 0 if the mesh has no material
+    uint64_t materialSize;
+  };
+
+#ifdef _WIN32
+
+  void setSceneCacheDirectory(const std::string &directory)
+  {
+    if (!directory.empty()) {
+      std::cerr << "the scene cache is not supported on Windows, ignoring "
+                << "--scene-cache " << directory << std::endl;
+    }
+  }
+
+  bool readSceneCache(const std::string &, ParsedScene &)
+  {
+    return false;
+  }
+
+  bool writeSceneCache(const std::string &, const ParsedScene &)
+  {
+    return false;
+  }
+
+#else
+
+  static std::string cacheDirectory;
+
+  void setSceneCacheDirectory(const std::string &directory)
+  {
+    cacheDirectory = directory;
+  }
+
+  static std::string absolutePath(const std::string &fileName)
+  {
+    char *resolved = realpath(fileName.c_str(), nullptr);
+    if (!resolved)
+      return fileName;
+
+    std::string path = resolved;
+    free(resolved);
+    return path;
+  }
+
+  static std::string cacheFileOf(const std::string &path)
+  {
+    char name[32];
+    snprintf(name, sizeof(name), "%016zx.ospcache",
+             std::hash<std::string>()(path));
+    return cacheDirectory + "/" + name;
+  }
+
+  static bool statSource(const std::string &path, CacheHeader &header)
+  {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+      return false;
+
+    header.sourceSize  = st.st_size;
+    header.sourceMTime = st.st_mtime;
+    return true;
+  }
+
+  // Material serialization //
+
+  static void putBytes(std::vector<char> &out, const void *data, size_t size)
+  {
+    out.insert(out.end(), (const char*)data, (const char*)data + size);
+  }
+
+  static void putString(std::vector<char> &out, const std::string &str)
+  {
+    uint32_t size = str.size();
+    putBytes(out, &size, sizeof(size));
+    putBytes(out, str.data(), size);
+  }
+
+  static std::vector<char> serialize(const SceneMaterial &material)
+  {
+    std::vector<char> out;
+
+    uint32_t numFloat = material.floatParams.size();
+    putBytes(out, &numFloat, sizeof(numFloat));
+    for (auto &p : material.floatParams) {
+      putString(out, p.first);
+      uint32_t n = p.second.size();
+      putBytes(out, &n, sizeof(n));
+      putBytes(out, p.second.data(), n * sizeof(float));
+    }
+
+    uint32_t numInt = material.intParams.size();
+    putBytes(out, &numInt, sizeof(numInt));
+    for (auto &p : material.intParams) {
+      putString(out, p.first);
+      int32_t v = p.second;
+      putBytes(out, &v, sizeof(v));
+    }
+
+    return out;
+  }
+
+  struct Reader
+  {
+    const char *at;
+    const char *end;
+
+    bool get(void *dst, size_t size)
+    {
+      if (size_t(end - at) < size)
+        return false;
+      std::memcpy(dst, at, size);
+      at += size;
+      return true;
+    }
+
+    bool getString(std::string &str)
+    {
+      uint32_t size = 0;
+      if (!get(&size, sizeof(size)) || size_t(end - at) < size)
+        return false;
+      str.assign(at, size);
+      at += size;
+      return true;
+    }
+  };
+
+  static bool deserialize(Reader in, SceneMaterial &material)
+  {
+    uint32_t numFloat = 0;
+    if (!in.get(&numFloat, sizeof(numFloat)))
+      return false;
+
+    for (uint32_t i = 0; i < numFloat; ++i) {
+      std::string name;
+      uint32_t n = 0;
+      if (!in.getString(name) || !in.get(&n, sizeof(n)) || n > 4)
+        return false;
+
+      auto &v = material.floatParams[name];
+      v.resize(n);
+      if (!in.get(v.data(), n * sizeof(float)))
+        return false;
+    }
+
+    uint32_t numInt = 0;
+    if (!in.get(&numInt, sizeof(numInt)))
+      return false;
+
+    for (uint32_t i = 0; i < numInt; ++i) {
+      std::string name;
+      int32_t v = 0;
+      if (!in.getString(name) || !in.get(&v, sizeof(v)))
+        return false;
+      material.intParams[name] = v;
+    }
+
+    return true;
+  }
+
+  // Cache files //
+
+  template <typename T>
+  static void mapArray(const char *bytes, const MeshEntry &entry, int a,
+                       SceneArray<T> &array)
+  {
+    array.mapped      = (const T*)(bytes + entry.offset[a]);
+    array.mappedCount = entry.count[a];
+  }
+
+  bool readSceneCache(const std::string &fileName, ParsedScene &scene)
+  {
+    if (cacheDirectory.empty())
+      return false;
+
+    const auto path = absolutePath(fileName);
+
+    CacheHeader source;
+    if (!statSource(path, source))
+      return false;
+
+    int fd = open(cacheFileOf(path).c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+
+    struct stat st;
+    void *base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(CacheHeader)) {
+      // NOTE: private and writable, so OSPRay may write to what it's given
+      //       without it ever reaching the file
+      base = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                  fd, 0);
+    }
+    close(fd);
+
+    if (base == MAP_FAILED)
+      return false;
+
+    const size_t fileSize = st.st_size;
+    std::shared_ptr<const void> mapping(base, [=](const void *p) {
+      munmap(const_cast<void*>(p), fileSize);
+    });
+
+    const char *bytes = (const char*)base;
+    Reader in {bytes, bytes + fileSize};
+
+    CacheHeader header;
+    in.get(&header, sizeof(header));
+
+    std::string cachedPath;
+    if (std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 ||
+        header.version != cacheVersion ||
+        header.sourceSize != source.sourceSize ||
+        header.sourceMTime != source.sourceMTime ||
+        header.pathLength != path.size() ||
+        size_t(in.end - in.at) < header.pathLength) {
+      return false;
+    }
+
+    cachedPath.assign(in.at, header.pathLength);
+    in.at += header.pathLength;
+    if (cachedPath != path)
+      return false;
+
+    ParsedScene cached;
+    cached.fileName = fileName;
+    cached.mapping  = mapping;
+    cached.bounds   = box3f(vec3f(header.bounds[0], header.bounds[1],
+                                  header.bounds[2]),
+                            vec3f(header.bounds[3], header.bounds[4],
+                                  header.bounds[5]));
+
+    const size_t elementSize[NUM_ARRAYS] = {
+      sizeof(vec3fa), sizeof(vec3fa), sizeof(vec3fa), sizeof(vec3i)
+    };
+
+    for (uint32_t m = 0; m < header.numMeshes; ++m) {
+      MeshEntry entry;
+      if (!in.get(&entry, sizeof(entry)))
+        return false;
+
+      for (int a = 0; a < NUM_ARRAYS; ++a) {
+        if (entry.offset[a] > fileSize ||
+            entry.count[a] > (fileSize - entry.offset[a]) / elementSize[a]) {
+          return false;
+        }
+      }
+
+      SceneMesh mesh;
+
+      mapArray(bytes, entry, POSITIONS, mesh.positions);
+      mapArray(bytes, entry, NORMALS, mesh.normals);
+      mapArray(bytes, entry, COLORS, mesh.colors);
+      mapArray(bytes, entry, INDICES, mesh.indices);
+
+      if (entry.materialOffset != 0) {
+        if (entry.materialOffset > fileSize ||
+            entry.materialSize > fileSize - entry.materialOffset) {
+          return false;
+        }
+
+        Reader material {bytes + entry.materialOffset,
+                         bytes + entry.materialOffset + entry.materialSize};
+        if (!deserialize(material, mesh.material))
+          return false;
+
+        mesh.hasMaterial = true;
+      }
+
+      cached.meshes.push_back(std::move(mesh));
+    }
+
+    scene = std::move(cached);
+    return true;
+  }
+
+  bool writeSceneCache(const std::string &fileName, const ParsedScene &scene)
+  {
+    if (cacheDirectory.empty())
+      return false;
+
+    const auto path = absolutePath(fileName);
+
+    CacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    if (!statSource(path, header))
+      return false;
+
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version    = cacheVersion;
+    header.numMeshes  = scene.meshes.size();
+    header.pathLength = path.size();
+    header.bounds[0]  = scene.bounds.lower.x;
+    header.bounds[1]  = scene.bounds.lower.y;
+    header.bounds[2]  = scene.bounds.lower.z;
+    header.bounds[3]  = scene.bounds.upper.x;
+    header.bounds[4]  = scene.bounds.upper.y;
+    header.bounds[5]  = scene.bounds.upper.z;
+
+    // lay out the arrays and materials behind the mesh table
+    std::vector<MeshEntry>         entries(scene.meshes.size());
+    std::vector<std::vector<char>> materials(scene.meshes.size());
+
+    auto align = [](uint64_t offset) {
+      return (offset + ARRAY_ALIGNMENT - 1) / ARRAY_ALIGNMENT * ARRAY_ALIGNMENT;
+    };
+
+    uint64_t offset = sizeof(header) + path.size() +
+                      entries.size() * sizeof(MeshEntry);
+
+    for (size_t m = 0; m < scene.meshes.size(); ++m) {
+      auto &mesh  = scene.meshes[m];
+      auto &entry = entries[m];
+
+      const size_t sizes[NUM_ARRAYS] = {
+        mesh.positions.size() * sizeof(vec3fa),
+        mesh.normals.size() * sizeof(vec3fa),
+        mesh.colors.size() * sizeof(vec3fa),
+        mesh.indices.size() * sizeof(vec3i)
+      };
+
+      entry.count[POSITIONS] = mesh.positions.size();
+      entry.count[NORMALS]   = mesh.normals.size();
+      entry.count[COLORS]    = mesh.colors.size();
+      entry.count[INDICES]   = mesh.indices.size();
+
+      for (int a = 0; a < NUM_ARRAYS; ++a) {
+        offset = align(offset);
+        entry.offset[a] = offset;
+        offset += sizes[a];
+      }
+
+      entry.materialOffset = 0;
+      entry.materialSize   = 0;
+
+      if (mesh.hasMaterial) {
+        materials[m] = serialize(mesh.material);
+        entry.materialOffset = offset;
+        entry.materialSize   = materials[m].size();
+        offset += entry.materialSize;
+      }
+    }
+
+    // NOTE: write to a temporary file first, so that a reader never maps a
+    //       half written cache file
+    mkdir(cacheDirectory.c_str(), 0755);
+
+    const auto cacheFile = cacheFileOf(path);
+    const auto tempFile  = cacheFile + ".tmp";
+
+    std::ofstream out(tempFile, std::ios::binary);
+    if (!out.is_open()) {
+      std::cerr << "failed to write scene cache '" << tempFile << "'"
+                << std::endl;
+      return false;
+    }
+
+    uint64_t written = 0;
+    auto write = [&](const void *data, size_t size) {
+      out.write((const char*)data, size);
+      written += size;
+    };
+
+    auto pad = [&](uint64_t to) {
+      static const char zeros[ARRAY_ALIGNMENT] = {};
+      while (written < to)
+        write(zeros, std::min<uint64_t>(to - written, ARRAY_ALIGNMENT));
+    };
+
+    write(&header, sizeof(header));
+    write(path.data(), path.size());
+    write(entries.data(), entries.size() * sizeof(MeshEntry));
+
+    for (size_t m = 0; m < scene.meshes.size(); ++m) {
+      auto &mesh  = scene.meshes[m];
+      auto &entry = entries[m];
+
+      pad(entry.offset[POSITIONS]);
+      write(mesh.positions.data(), entry.count[POSITIONS] * sizeof(vec3fa));
+      pad(entry.offset[NORMALS]);
+      write(mesh.normals.data(), entry.count[NORMALS] * sizeof(vec3fa));
+      pad(entry.offset[COLORS]);
+      write(mesh.colors.data(), entry.count[COLORS] * sizeof(vec3fa));
+      pad(entry.offset[INDICES]);
+      write(mesh.indices.data(), entry.count[INDICES] * sizeof(vec3i));
+
+      write(materials[m].data(), materials[m].size());
+    }
+
+    out.close();
+
+    if (!out || std::rename(tempFile.c_str(), cacheFile.c_str()) != 0) {
+      std::cerr << "failed to write scene cache '" << cacheFile << "'"
+                << std::endl;
+      std::remove(tempFile.c_str());
+      return false;
+    }
+
+    return true;
+  }
+
+#endif
+
+}// namespace ospray
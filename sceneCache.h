@@ -0,0 +1,38 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "sceneLoader.h"
+
+namespace ospray {
+
+  /*! keep parsed scenes in 'directory' (an empty one disables the cache),
+      one file per input holding all of its arrays, aligned so they can be
+      mapped and handed to OSPRay as they are. Only the inputs
+      parseSceneFile() reads (OBJ, PLY and STL) get cached. Not supported on
+      Windows, where the cache stays disabled */
+  void setSceneCacheDirectory(const std::string &directory);
+
+  /*! map the cache file of 'fileName'; fails if there is none, or if it was
+      made from a different version (path, size or time) of the input. The
+      file stays mapped for as long as 'scene.mapping' is referenced */
+  bool readSceneCache(const std::string &fileName, ParsedScene &scene);
+
+  /*! (re)write the cache file of 'fileName', returns false on failure */
+  bool writeSceneCache(const std::string &fileName, const ParsedScene &scene);
+
+}// namespace ospray
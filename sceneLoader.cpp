@@ -0,0 +1,300 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "sceneLoader.h"
+#include "sceneCache.h"
+
+// mini scene graph for parsing the input files
+#include "common/miniSG/miniSG.h"
+
+#include <ospcommon/tasking/parallel_for.h>
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+using namespace ospcommon;
+
+namespace ospray {
+
+  size_t ParsedScene::bytes() const
+  {
+    size_t total = 0;
+    for (auto &mesh : meshes) {
+      total += mesh.positions.size() * sizeof(vec3fa);
+      total += mesh.normals.size() * sizeof(vec3fa);
+      total += mesh.colors.size() * sizeof(vec3fa);
+      total += mesh.indices.size() * sizeof(vec3i);
+    }
+    return total;
+  }
+
+  static SceneMaterial parseMaterial(const miniSG::Material &msgMaterial)
+  {
+    using Param = miniSG::Material::Param;
+
+    SceneMaterial material;
+
+    for (auto &p : msgMaterial.params) {
+      auto &param = *p.second;
+      switch (param.type) {
+      case Param::INT:
+        material.intParams[p.first] = param.i[0];
+        break;
+      case Param::FLOAT:
+      case Param::FLOAT_2:
+      case Param::FLOAT_3:
+      case Param::FLOAT_4:
+        material.floatParams[p.first].assign(
+            param.f, param.f + 1 + int(param.type) - int(Param::FLOAT));
+        break;
+      default:
+        // NOTE: textures and strings aren't carried over
+        break;
+      }
+    }
+
+    return material;
+  }
+
+  bool isSceneFile(const std::string &fileName)
+  {
+    auto ext = FileName(fileName).ext();
+    return ext == "obj" || ext == "ply" || ext == "stl";
+  }
+
+  bool parseSceneFile(const std::string &fileName, ParsedScene &scene)
+  {
+    ospcommon::FileName fn = fileName;
+    miniSG::Model msgModel;
+
+    try {
+      if (fn.ext() == "obj")
+        miniSG::importOBJ(msgModel, fn);
+      else if (fn.ext() == "ply")
+        miniSG::importPLY(msgModel, fn);
+      else if (fn.ext() == "stl")
+        miniSG::importSTL(msgModel, fn);
+      else
+        throw std::runtime_error("unsupported file type");
+    } catch (const std::exception &e) {
+      std::cerr << "failed to load '" << fileName << "': " << e.what()
+                << std::endl;
+      return false;
+    }
+
+    scene.fileName = fileName;
+    scene.bounds   = msgModel.getBBox();
+    scene.meshes.clear();
+    scene.meshes.reserve(msgModel.mesh.size());
+
+    for (auto &msgMesh : msgModel.mesh) {
+      SceneMesh mesh;
+      if (msgMesh->material) {
+        mesh.material    = parseMaterial(*msgMesh->material);
+        mesh.hasMaterial = true;
+      }
+
+      mesh.positions.owned = msgMesh->position;
+      mesh.normals.owned   = msgMesh->normal;
+      mesh.colors.owned    = msgMesh->color;
+
+      // NOTE: OSPRay reads vertex colors as RGBA
+      for (auto &c : mesh.colors.owned)
+        c.w = 1.f;
+
+      auto &indices = mesh.indices.owned;
+      indices.reserve(msgMesh->triangle.size());
+      for (auto &t : msgMesh->triangle)
+        indices.emplace_back(int(t.v0), int(t.v1), int(t.v2));
+
+      scene.meshes.push_back(std::move(mesh));
+    }
+
+    return true;
+  }
+
+  bool loadSceneFile(const std::string &fileName, ParsedScene &scene)
+  {
+    if (readSceneCache(fileName, scene))
+      return true;
+
+    if (!parseSceneFile(fileName, scene))
+      return false;
+
+    writeSceneCache(fileName, scene);
+    return true;
+  }
+
+  static OSPMaterial createMaterial(const SceneMaterial &material,
+                                    cpp::Renderer renderer)
+  {
+    OSPMaterial ospMaterial =
+        ospNewMaterial((OSPRenderer)renderer.object(), "OBJMaterial");
+
+    for (auto &p : material.floatParams) {
+      auto &v = p.second;
+      if (v.size() == 1)
+        ospSet1f((OSPObject)ospMaterial, p.first.c_str(), v[0]);
+      else if (v.size() >= 3)
+        ospSet3fv((OSPObject)ospMaterial, p.first.c_str(), v.data());
+    }
+
+    for (auto &p : material.intParams)
+      ospSet1i((OSPObject)ospMaterial, p.first.c_str(), p.second);
+
+    ospCommit((OSPObject)ospMaterial);
+    return ospMaterial;
+  }
+
+  cpp::Model createModel(const ParsedScene &scene, cpp::Renderer renderer)
+  {
+    cpp::Model model;
+    addToModel(scene, renderer, model);
+    model.commit();
+    return model;
+  }
+
+  void addToModel(const ParsedScene &scene, cpp::Renderer renderer,
+                  cpp::Model &model)
+  {
+    for (auto &mesh : scene.meshes) {
+      OSPGeometry geometry = ospNewGeometry("triangles");
+
+      // NOTE: arrays in a mapped cache file are handed to OSPRay as they
+      //       are, the caller keeps the mapping alive
+      const uint32_t flags = scene.mapping ? OSP_DATA_SHARED_BUFFER : 0;
+
+      auto setArray = [&](const char *name, size_t count, OSPDataType type,
+                          const void *data) {
+        if (count == 0)
+          return;
+        OSPData array = ospNewData(count, type, data, flags);
+        ospCommit(array);
+        ospSetData(geometry, name, array);
+        ospRelease(array);
+      };
+
+      setArray("vertex", mesh.positions.size(), OSP_FLOAT3A,
+               mesh.positions.data());
+      setArray("vertex.normal", mesh.normals.size(), OSP_FLOAT3A,
+               mesh.normals.data());
+      setArray("vertex.color", mesh.colors.size(), OSP_FLOAT4,
+               mesh.colors.data());
+      setArray("index", mesh.indices.size(), OSP_INT3,
+               mesh.indices.data());
+
+      if (mesh.hasMaterial) {
+        auto material = createMaterial(mesh.material, renderer);
+        ospSetMaterial(geometry, material);
+        ospRelease((OSPObject)material);
+      }
+
+      ospCommit(geometry);
+      model.addGeometry(geometry);
+      ospRelease(geometry);
+    }
+  }
+
+  cpp::Model loadSceneFiles(const std::vector<std::string> &fileNames,
+                            cpp::Renderer renderer,
+                            box3f &bounds,
+                            std::vector<std::shared_ptr<const void>> &mappings)
+  {
+    const size_t numFiles = fileNames.size();
+
+    std::vector<ParsedScene> scenes(numFiles);
+    std::vector<char>   parsed(numFiles, false);
+    std::vector<double> parseTime(numFiles, 0.0);
+    std::vector<double> createTime(numFiles, 0.0);
+    std::vector<size_t> fileBytes(numFiles, 0);
+    std::vector<char>   fromCache(numFiles, false);
+
+    // NOTE: parsing only touches the file's own ParsedScene, so the files can
+    //       be read in parallel; talking to OSPRay stays on this thread
+    auto loadStart = getSysTime();
+
+    tasking::parallel_for(int(numFiles), [&](int i) {
+      auto start   = getSysTime();
+      parsed[i]    = loadSceneFile(fileNames[i], scenes[i]);
+      parseTime[i] = getSysTime() - start;
+    });
+
+    auto parseEnd = getSysTime();
+
+    cpp::Model model(nullptr);
+    bool haveBounds = false;
+
+    for (size_t i = 0; i < numFiles; ++i) {
+      if (!parsed[i])
+        continue;
+
+      if (!model.handle())
+        model = cpp::Model();
+
+      auto start = getSysTime();
+      addToModel(scenes[i], renderer, model);
+      createTime[i] = getSysTime() - start;
+      fileBytes[i]  = scenes[i].bytes();
+      fromCache[i]  = scenes[i].mapping != nullptr;
+
+      if (haveBounds) {
+        bounds.extend(scenes[i].bounds);
+      } else {
+        bounds     = scenes[i].bounds;
+        haveBounds = true;
+      }
+
+      // NOTE: OSPRay has its own copy of the arrays by now, unless they are
+      //       mapped from the cache
+      if (scenes[i].mapping)
+        mappings.push_back(scenes[i].mapping);
+      scenes[i] = ParsedScene();
+    }
+
+    auto commitStart = getSysTime();
+    if (model.handle())
+      model.commit();
+    auto loadEnd = getSysTime();
+
+    printf("%-40s %10s %10s %10s %s\n", "file", "MB", "parse ms",
+           "create ms", "cached");
+    for (size_t i = 0; i < numFiles; ++i) {
+      auto name = fileNames[i];
+      if (name.size() > 40)
+        name = "..." + name.substr(name.size() - 37);
+
+      if (!parsed[i]) {
+        printf("%-40s %10s\n", name.c_str(), "failed");
+        continue;
+      }
+
+      printf("%-40s %10.1f %10.1f %10.1f %s\n", name.c_str(),
+             fileBytes[i] / (1024.0 * 1024.0),
+             parseTime[i] * 1000.0, createTime[i] * 1000.0,
+             fromCache[i] ? "yes" : "no");
+    }
+    printf("parsed %i files in %.1f ms (wall), committed in %.1f ms, "
+           "total %.1f ms\n", int(numFiles),
+           (parseEnd - loadStart) * 1000.0,
+           (loadEnd - commitStart) * 1000.0,
+           (loadEnd - loadStart) * 1000.0);
+    fflush(stdout);
+
+    return model;
+  }
+
+}// namespace ospray
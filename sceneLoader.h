@@ -0,0 +1,109 @@
+// ======================================================================== //
+// Copyright 2009-2017 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ospcommon/box.h>
+#include <ospray/ospray_cpp/Model.h>
+#include <ospray/ospray_cpp/Renderer.h>
+
+namespace ospray {
+
+  /*! the numeric parameters of a mesh's OBJ material */
+  struct SceneMaterial
+  {
+    std::map<std::string, std::vector<float>> floatParams;
+    std::map<std::string, int>                intParams;
+  };
+
+  /*! an array either owned by the scene (freshly parsed) or pointing into
+      memory kept alive by ParsedScene::mapping (a scene cache file) */
+  template <typename T>
+  struct SceneArray
+  {
+    std::vector<T> owned;
+    const T *mapped {nullptr};
+    size_t   mappedCount {0};
+
+    const T *data() const { return mapped ? mapped : owned.data(); }
+    size_t   size() const { return mapped ? mappedCount : owned.size(); }
+  };
+
+  /*! triangle mesh arrays, laid out the way OSPRay's "triangles" geometry
+      takes them */
+  struct SceneMesh
+  {
+    SceneMaterial material;
+    bool          hasMaterial {false};
+
+    SceneArray<ospcommon::vec3fa> positions;
+    SceneArray<ospcommon::vec3fa> normals;
+    SceneArray<ospcommon::vec3fa> colors;
+    SceneArray<ospcommon::vec3i>  indices;
+  };
+
+  /*! the meshes of one input file, parsed but not yet handed to OSPRay */
+  struct ParsedScene
+  {
+    std::string            fileName;
+    std::vector<SceneMesh> meshes;
+    ospcommon::box3f       bounds;
+
+    /*! set when the arrays live in a mapped cache file, which OSPRay then
+        uses directly instead of copying */
+    std::shared_ptr<const void> mapping;
+
+    size_t bytes() const;
+  };
+
+  /*! whether parseSceneFile() can read the file, judging by its extension */
+  bool isSceneFile(const std::string &fileName);
+
+  /*! parse an OBJ, PLY or STL file; returns false (and reports why) if the
+      file couldn't be read */
+  bool parseSceneFile(const std::string &fileName, ParsedScene &scene);
+
+  /*! like parseSceneFile(), but going through the scene cache when one is
+      set up (\see setSceneCacheDirectory()) */
+  bool loadSceneFile(const std::string &fileName, ParsedScene &scene);
+
+  /*! create and commit a model holding one geometry per mesh
+
+      NOTE: the arrays of a mapped scene are shared with OSPRay, not copied,
+            so 'scene.mapping' has to be kept alive as long as the model */
+  cpp::Model createModel(const ParsedScene &scene, cpp::Renderer renderer);
+
+  /*! add one geometry per mesh to 'model', without committing it (the same
+      NOTE as for createModel() applies) */
+  void addToModel(const ParsedScene &scene, cpp::Renderer renderer,
+                  cpp::Model &model);
+
+  /*! parse all files concurrently, then combine them into a single model;
+      prints how long each file took. Files that fail to load are skipped,
+      an invalid model is returned if none could be loaded. The mappings of
+      any cached files are added to 'mappings', which must outlive the
+      model */
+  cpp::Model loadSceneFiles(const std::vector<std::string> &fileNames,
+                            cpp::Renderer renderer,
+                            ospcommon::box3f &bounds,
+                            std::vector<std::shared_ptr<const void>> &mappings);
+
+}// namespace ospray
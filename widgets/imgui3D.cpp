@@ -19,6 +19,8 @@
 
 #include <imgui.h>
 #include "imgui_impl_glfw_gl3.h"
+#include "../common/util/latency_tracker.h"
+#include "../common/util/startup_profiler.h"
 #include <stdio.h>
 #include <GL/gl3w.h>
 #include <GLFW/glfw3.h>
@@ -29,11 +31,12 @@
 #  endif
 #  define _USE_MATH_DEFINES
 #  include <math.h> // M_PI
-#else
-#  include <sys/times.h>
 #endif
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -41,46 +44,255 @@
 extern "C" void glDrawPixels( GLsizei width, GLsizei height,
                               GLenum format, GLenum type,
                               const GLvoid *pixels );
+extern "C" void glPixelZoom( GLfloat xfactor, GLfloat yfactor );
 
 namespace ospray {
 
   namespace imgui3D {
 
-    bool dumpScreensDuringAnimation = false;
+    /*! what startRecording() records to; set with --record, --record-fps
+        and --record-block on the command line */
+    static RecordingSettings recordingSettings;
 
     static ImGui3DWidget *currentWidget = nullptr;
 
     bool ImGui3DWidget::showGui = true;
 
-    // Class definitions //////////////////////////////////////////////////////
+    bool  ImGui3DWidget::idleWhenUnchanged = true;
+    float ImGui3DWidget::maxIdleRedrawRate = 4.f;
 
-    /*! write given frame buffer to file, in PPM P6 format. */
-    void saveFrameBufferToFile(const char *fileName,
-                               const uint32_t *pixel,
-                               const uint32_t sizeX, const uint32_t sizeY)
+    // NOTE: redraws can get requested from other threads, which must not
+    //       touch GLFW before it was initialized or after it was terminated;
+    //       the mutex keeps a request from racing with glfwTerminate()
+    static std::mutex glfwRunningMutex;
+    static bool       glfwRunning {false};
+
+    // Frame buffer streaming /////////////////////////////////////////////////
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#  define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#  define GL_MAP_COHERENT_BIT   0x0080
+#endif
+
+    // NOTE: glBufferStorage() (GL 4.4) is newer than our gl3w, so it gets
+    //       loaded by hand when the driver provides it
+    typedef void (APIENTRYP BufferStorageFcn)(GLenum target, GLsizeiptr size,
+                                              const void *data,
+                                              GLbitfield flags);
+
+    /*! streams frame buffer data into a texture through a ring of pixel
+        buffer objects (persistently mapped where supported) and blits that
+        texture into the window, scaling it to fit */
+    struct FrameTexture
+    {
+      static const int NUM_PBOS = 3;
+
+      bool initialized {false};
+      bool supported   {false};
+      bool persistent  {false};
+
+      GLuint texture {0};
+      GLuint fbo     {0};
+      GLuint pbos[NUM_PBOS] {};
+      GLsync fences[NUM_PBOS] {};
+      void  *mapped[NUM_PBOS] {};
+      int    nextPBO {0};
+
+      vec2i  size {0, 0};
+      GLenum type {GL_UNSIGNED_BYTE};
+      size_t bytes {0};
+
+      BufferStorageFcn bufferStorage {nullptr};
+
+      void init();
+      void release();
+      void resize(const vec2i &newSize, GLenum newType);
+      void upload(const void *pixels);
+      void draw(const vec2i &windowSize);
+
+    private:
+
+      void waitForFence(int pbo);
+      void allocatePBOs();
+      void releasePBOs();
+    };
+
+    static FrameTexture frameTexture;
+
+    void FrameTexture::init()
+    {
+      initialized = true;
+      supported   = gl3wIsSupported(3, 0);
+
+      if (!supported)
+        return;
+
+      bufferStorage = (BufferStorageFcn)glfwGetProcAddress("glBufferStorage");
+      persistent    = bufferStorage != nullptr &&
+                      (gl3wIsSupported(4, 4) ||
+                       glfwExtensionSupported("GL_ARB_buffer_storage"));
+
+      glGenTextures(1, &texture);
+      glGenFramebuffers(1, &fbo);
+    }
+
+    void FrameTexture::release()
     {
-      FILE *file = fopen(fileName,"wb");
-      if (!file) {
-        std::cerr << "#osp:glut3D: Warning - could not create screenshot file '"
-                  << fileName << "'" << std::endl;
+      if (!supported)
         return;
+
+      releasePBOs();
+      glDeleteFramebuffers(1, &fbo);
+      glDeleteTextures(1, &texture);
+      supported = false;
+    }
+
+    void FrameTexture::resize(const vec2i &newSize, GLenum newType)
+    {
+      if (newSize == size && newType == type)
+        return;
+
+      size  = newSize;
+      type  = newType;
+      bytes = size_t(size.x) * size.y * (type == GL_FLOAT ? 16 : 4);
+
+      releasePBOs();
+      allocatePBOs();
+
+      GLint lastTexture;
+      glGetIntegerv(GL_TEXTURE_BINDING_2D, &lastTexture);
+      glBindTexture(GL_TEXTURE_2D, texture);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      glTexImage2D(GL_TEXTURE_2D, 0, type == GL_FLOAT ? GL_RGBA32F : GL_RGBA8,
+                   size.x, size.y, 0, GL_RGBA, type, nullptr);
+      glBindTexture(GL_TEXTURE_2D, lastTexture);
+
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+      glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                             GL_TEXTURE_2D, texture, 0);
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    }
+
+    void FrameTexture::upload(const void *pixels)
+    {
+      auto pbo = nextPBO;
+      nextPBO  = (nextPBO + 1) % NUM_PBOS;
+
+      // NOTE: this buffer was last used NUM_PBOS uploads ago, so the GPU is
+      //       almost always done reading it by now
+      waitForFence(pbo);
+
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[pbo]);
+
+      if (persistent) {
+        memcpy(mapped[pbo], pixels, bytes);
+      } else {
+        // orphan the old storage instead of waiting for the GPU to release it
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+        auto *dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                     GL_MAP_WRITE_BIT |
+                                     GL_MAP_INVALIDATE_BUFFER_BIT);
+        memcpy(dst, pixels, bytes);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
       }
-      fprintf(file,"P6\n%i %i\n255\n",sizeX,sizeY);
-      unsigned char *out = (unsigned char *)alloca(3*sizeX);
-      for (size_t y = 0; y < sizeY; y++) {
-        const unsigned char *in =
-            (const unsigned char *)&pixel[(sizeY-1-y)*sizeX];
-        for (size_t x = 0; x < sizeX; x++) {
-          out[3*x+0] = in[4*x+0];
-          out[3*x+1] = in[4*x+1];
-          out[3*x+2] = in[4*x+2];
+
+      GLint lastTexture;
+      glGetIntegerv(GL_TEXTURE_BINDING_2D, &lastTexture);
+      glBindTexture(GL_TEXTURE_2D, texture);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size.x, size.y,
+                      GL_RGBA, type, nullptr);
+      glBindTexture(GL_TEXTURE_2D, lastTexture);
+
+      fences[pbo] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    void FrameTexture::draw(const vec2i &windowSize)
+    {
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+      glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+      glBlitFramebuffer(0, 0, size.x, size.y,
+                        0, 0, windowSize.x, windowSize.y,
+                        GL_COLOR_BUFFER_BIT,
+                        size == windowSize ? GL_NEAREST : GL_LINEAR);
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    }
+
+    void FrameTexture::waitForFence(int pbo)
+    {
+      if (!fences[pbo])
+        return;
+
+      const GLuint64 oneSecond = 1000000000;
+      glClientWaitSync(fences[pbo], GL_SYNC_FLUSH_COMMANDS_BIT, oneSecond);
+      glDeleteSync(fences[pbo]);
+      fences[pbo] = nullptr;
+    }
+
+    void FrameTexture::allocatePBOs()
+    {
+      glGenBuffers(NUM_PBOS, pbos);
+
+      for (int i = 0; i < NUM_PBOS; ++i) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[i]);
+
+        if (persistent) {
+          const GLbitfield flags = GL_MAP_WRITE_BIT |
+                                   GL_MAP_PERSISTENT_BIT |
+                                   GL_MAP_COHERENT_BIT;
+          bufferStorage(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, flags);
+          mapped[i] = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, flags);
+        } else {
+          glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
         }
-        fwrite(out, 3*sizeX, sizeof(char), file);
       }
-      fprintf(file,"\n");
-      fclose(file);
-      std::cout << "#osp:glut3D: saved framebuffer to file "
-                << fileName << std::endl;
+
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    void FrameTexture::releasePBOs()
+    {
+      if (!pbos[0])
+        return;
+
+      for (int i = 0; i < NUM_PBOS; ++i) {
+        waitForFence(i);
+
+        if (mapped[i]) {
+          glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[i]);
+          glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+          mapped[i] = nullptr;
+        }
+      }
+
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      glDeleteBuffers(NUM_PBOS, pbos);
+
+      for (auto &pbo : pbos)
+        pbo = 0;
+    }
+
+    // Class definitions //////////////////////////////////////////////////////
+
+    /*! write given frame buffer to file, in PPM P6 format. The pixels get
+        copied and written in the background, so this never blocks */
+    void saveFrameBufferToFile(async_image_writer &writer,
+                               const char *fileName,
+                               const uint32_t *pixel,
+                               const uint32_t sizeX, const uint32_t sizeY)
+    {
+      auto pixels = std::make_shared<const std::vector<uint32_t>>(
+          pixel, pixel + size_t(sizeX) * sizeY);
+
+      if (!writer.write(fileName, ImageFormat::PPM, vec2i(sizeX, sizeY),
+                        std::move(pixels))) {
+        std::cerr << "#osp:glut3D: Warning - too many screenshots pending, "
+                  << "dropped '" << fileName << "'" << std::endl;
+      }
     }
 
 #define INVERT_RMB 
@@ -118,11 +330,22 @@ namespace ospray {
       frame.l.vy = normalize(cross(frame.l.vz,frame.l.vx));
     }
 
+    void ImGui3DWidget::mouseButton(int button, int action, int mods)
+    {
+      if (button >= 0 && button < 3)
+        currButton[button] = action;
+    }
+
     void ImGui3DWidget::motion(const vec2i &pos)
     {
+      auto eventTime = monotonicTime();
+
       currMousePos = pos;
       if (!renderingPaused) manipulator->motion(this);
       lastMousePos = currMousePos;
+
+      if (viewPort.modified && pendingInputTime < 0.0)
+        pendingInputTime = eventTime;
     }
 
     ImGui3DWidget::ImGui3DWidget(FrameBufferMode frameBufferMode,
@@ -134,7 +357,8 @@ namespace ospray {
       motionSpeed(.003f),
       rotateSpeed(.003f),
       frameBufferMode(frameBufferMode),
-      ucharFB(nullptr)
+      ucharFB(nullptr),
+      frameBufferSize(-1,-1)
     {
       if (activeWindow != nullptr)
         throw std::runtime_error("ERROR: Can't create more than one ImGui3DWidget!");
@@ -194,6 +418,7 @@ namespace ospray {
     void ImGui3DWidget::reshape(const vec2i &newSize)
     {
       windowSize = newSize;
+      frameBufferSize = newSize;
       viewPort.aspect = newSize.x/float(newSize.y);
     }
 
@@ -205,38 +430,109 @@ namespace ospray {
         hack->rotate(-10.f * ImGui3DWidget::activeWindow->motionSpeed, 0);
       }
 
-      if (frameBufferMode == ImGui3DWidget::FRAMEBUFFER_UCHAR && ucharFB) {
-        glDrawPixels(windowSize.x, windowSize.y,
-                     GL_RGBA, GL_UNSIGNED_BYTE, ucharFB);
-#ifndef _WIN32
-        if (ImGui3DWidget::animating && dumpScreensDuringAnimation) {
-          char tmpFileName[] = "/tmp/ospray_scene_dump_file.XXXXXXXXXX";
-          static const char *dumpFileRoot;
-          if (!dumpFileRoot) 
-            dumpFileRoot = getenv("OSPRAY_SCREEN_DUMP_ROOT");
-          if (!dumpFileRoot) {
-            auto rc = mkstemp(tmpFileName);
-            (void)rc;
-            dumpFileRoot = tmpFileName;
-          }
+      const void *pixels = nullptr;
+      GLenum type = GL_UNSIGNED_BYTE;
 
-          char fileName[100000];
-          sprintf(fileName,"%s_%08ld.ppm",dumpFileRoot,times(nullptr));
-          saveFrameBufferToFile(fileName,ucharFB,windowSize.x,windowSize.y);
-        }
-#endif
+      if (frameBufferMode == ImGui3DWidget::FRAMEBUFFER_UCHAR && ucharFB) {
+        pixels = ucharFB;
       } else if (frameBufferMode == ImGui3DWidget::FRAMEBUFFER_FLOAT && floatFB) {
-        glDrawPixels(windowSize.x, windowSize.y, GL_RGBA, GL_FLOAT, floatFB);
-      } else {
+        pixels = floatFB;
+        type   = GL_FLOAT;
+      }
+
+      if (!pixels) {
         glClearColor(0.f,0.f,0.f,1.f);
         glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+        return;
       }
+
+      const bool newPixels = frameBufferUpdated;
+
+      if (!frameTexture.initialized)
+        frameTexture.init();
+
+      if (frameTexture.supported) {
+        // NOTE: only stream pixels to the GPU when they actually changed
+        if (newPixels ||
+            frameTexture.size != frameBufferSize || frameTexture.type != type) {
+          frameTexture.resize(frameBufferSize, type);
+          frameTexture.upload(pixels);
+        }
+
+        frameTexture.draw(windowSize);
+      } else {
+        glPixelZoom(windowSize.x / float(frameBufferSize.x),
+                    windowSize.y / float(frameBufferSize.y));
+        glDrawPixels(frameBufferSize.x, frameBufferSize.y,
+                     GL_RGBA, type, pixels);
+        glPixelZoom(1.f, 1.f);
+      }
+
+      frameBufferUpdated = false;
     }
 
     void ImGui3DWidget::buildGui()
     {
     }
 
+    bool ImGui3DWidget::startRecording()
+    {
+      auto settings = recordingSettings;
+      settings.size = windowSize;
+
+      if (settings.path.empty()) {
+        const char *root = getenv("OSPRAY_SCREEN_DUMP_ROOT");
+        settings.path = std::string(root ? root : "ospray_recording") + ".y4m";
+      }
+
+      auto ext = settings.path.substr(settings.path.find_last_of('.') + 1);
+      settings.format = ext == "y4m" ? RecordingFormat::Y4M
+                                     : RecordingFormat::RGBA;
+
+      if (!recorder.start(settings)) {
+        std::cerr << "#osp:glut3D: could not start recording to '"
+                  << settings.path << "'" << std::endl;
+        return false;
+      }
+
+      std::cout << "#osp:glut3D: recording " << settings.size.x << "x"
+                << settings.size.y << " frames to '" << settings.path << "'"
+                << std::endl;
+      return true;
+    }
+
+    void ImGui3DWidget::stopRecording()
+    {
+      if (!recorder.isRecording())
+        return;
+
+      recorder.stop();
+
+      auto stats = recorder.stats();
+      std::cout << "#osp:glut3D: recorded " << stats.written << " frames ("
+                << stats.dropped << " dropped, " << stats.blocked
+                << " waited for a free buffer)" << std::endl;
+    }
+
+    void ImGui3DWidget::toggleRecording()
+    {
+      if (recorder.isRecording())
+        stopRecording();
+      else
+        startRecording();
+    }
+
+    void ImGui3DWidget::close()
+    {
+      if (window)
+        glfwSetWindowShouldClose(window, 1);
+    }
+
+    bool ImGui3DWidget::needsContinuousRedraw() const
+    {
+      return animating;
+    }
+
     void ImGui3DWidget::setViewPort(const vec3f from,
                                     const vec3f at,
                                     const vec3f up)
@@ -304,19 +600,34 @@ namespace ospray {
 
       glfwSetErrorCallback(error_callback);
 
+      auto &profiler = startup_profiler::instance();
+
+      profiler.begin("create: glfw window");
+
       if (!glfwInit())
         throw std::runtime_error("Could not initialize glfw!");
 
+      {
+        std::lock_guard<std::mutex> lock{glfwRunningMutex};
+        glfwRunning = true;
+      }
+
       glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
       glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
 
       window = glfwCreateWindow(size.x, size.y, title, nullptr, nullptr);
 
       glfwMakeContextCurrent(window);
+      profiler.end("create: glfw window");
+
+      profiler.begin("create: gl3w");
       gl3wInit();
+      profiler.end("create: gl3w");
 
       // NOTE(jda) - move key handler registration into this class
+      profiler.begin("create: imgui backend");
       ImGui_ImplGlfwGL3_Init(window, true);
+      profiler.end("create: imgui backend");
 
 
       glfwSetCursorPosCallback(
@@ -331,7 +642,7 @@ namespace ospray {
       glfwSetMouseButtonCallback(
         window,
         [](GLFWwindow*, int button, int action, int mods) {
-          ImGui3DWidget::activeWindow->currButton[button] = action;
+          ImGui3DWidget::activeWindow->mouseButton(button, action, mods);
         }
       );
 
@@ -359,12 +670,32 @@ namespace ospray {
 
       int display_w = 0, display_h = 0;
 
+      bool firstNewFrame = true;
+
       // Main loop
       while (!glfwWindowShouldClose(window))
       {
-        glfwPollEvents();
+        if (ImGui3DWidget::idleWhenUnchanged &&
+            !currentWidget->needsContinuousRedraw()) {
+          // NOTE: new frames and other redraw requests post an empty event,
+          //       so this only times out to bound the idle redraw rate
+          auto rate = std::max(ImGui3DWidget::maxIdleRedrawRate, 0.01f);
+          glfwWaitEventsTimeout(1.0 / rate);
+        } else {
+          glfwPollEvents();
+        }
+
+        // NOTE: the first new frame is when ImGui builds its font atlas
+        if (firstNewFrame)
+          startup_profiler::instance().begin("imgui: first frame (fonts)");
+
         ImGui_ImplGlfwGL3_NewFrame();
 
+        if (firstNewFrame) {
+          startup_profiler::instance().end("imgui: first frame (fonts)");
+          firstNewFrame = false;
+        }
+
         if (ImGui3DWidget::showGui)
           currentWidget->buildGui();
 
@@ -392,10 +723,24 @@ namespace ospray {
       }
 
       // Cleanup
+      currentWidget->stopRecording();
+      frameTexture.release();
       ImGui_ImplGlfwGL3_Shutdown();
+      {
+        std::lock_guard<std::mutex> lock{glfwRunningMutex};
+        glfwRunning = false;
+      }
+
       glfwTerminate();
     }
 
+    void requestRedraw()
+    {
+      std::lock_guard<std::mutex> lock{glfwRunningMutex};
+      if (glfwRunning)
+        glfwPostEmptyEvent();
+    }
+
     void init(int32_t *ac, const char **av)
     {
       for(int i = 1; i < *ac;i++)
@@ -421,6 +766,18 @@ namespace ospray {
               ImGui3DWidget::defaultInitSize.y = 1024;
           removeArgs(*ac,(char **&)av,i,1); --i;
           continue;
+        } if (arg == "--record") {
+          recordingSettings.path = av[i+1];
+          removeArgs(*ac,(char **&)av,i,2); --i;
+          continue;
+        } if (arg == "--record-fps") {
+          recordingSettings.fps = atoi(av[i+1]);
+          removeArgs(*ac,(char **&)av,i,2); --i;
+          continue;
+        } if (arg == "--record-block") {
+          recordingSettings.policy = RecordingPolicy::BLOCK;
+          removeArgs(*ac,(char **&)av,i,1); --i;
+          continue;
         } if (arg == "--size") {
           ImGui3DWidget::defaultInitSize.x = atoi(av[i+1]);
           ImGui3DWidget::defaultInitSize.y = atoi(av[i+2]);
@@ -530,12 +887,12 @@ namespace ospray {
     void InspectCenter::rotate(float du, float dv)
     {
       ImGui3DWidget::ViewPort &cam = widget->viewPort;
-      const vec3f pivot = widget->viewPort.at;//center(widget->worldBounds);
+      const vec3f center = orbitCenter();
       AffineSpace3fa xfm
-        = AffineSpace3fa::translate(pivot)
+        = AffineSpace3fa::translate(center)
         * AffineSpace3fa::rotate(cam.frame.l.vx,-dv)
         * AffineSpace3fa::rotate(cam.frame.l.vz,-du)
-        * AffineSpace3fa::translate(-pivot);
+        * AffineSpace3fa::translate(-center);
       cam.frame = xfm * cam.frame;
       cam.from  = xfmPoint(xfm,cam.from);
       cam.at    = xfmPoint(xfm,cam.at);
@@ -543,6 +900,22 @@ namespace ospray {
       cam.modified = true;
     }
 
+    void InspectCenter::setPivot(const vec3f &newPivot)
+    {
+      pivot    = newPivot;
+      hasPivot = true;
+    }
+
+    void InspectCenter::clearPivot()
+    {
+      hasPivot = false;
+    }
+
+    vec3f InspectCenter::orbitCenter() const
+    {
+      return hasPivot ? pivot : widget->viewPort.at;
+    }
+
     /*! INSPECT_CENTER::RightButton: move lookfrom/viewPort positoin
       forward/backward on right mouse button */
     void InspectCenter::dragRight(ImGui3DWidget *widget,
@@ -592,12 +965,12 @@ namespace ospray {
       float du = (to.x - from.x) * widget->rotateSpeed;
       float dv = (to.y - from.y) * widget->rotateSpeed;
 
-      const vec3f pivot = cam.at;
+      const vec3f center = orbitCenter();
       AffineSpace3fa xfm
-        = AffineSpace3fa::translate(pivot)
+        = AffineSpace3fa::translate(center)
         * AffineSpace3fa::rotate(cam.frame.l.vx,-dv)
         * AffineSpace3fa::rotate(cam.frame.l.vz,-du)
-        * AffineSpace3fa::translate(-pivot);
+        * AffineSpace3fa::translate(-center);
       cam.frame = xfm * cam.frame;
       cam.from  = xfmPoint(xfm,cam.from);
       cam.at    = xfmPoint(xfm,cam.at);
@@ -668,7 +1041,7 @@ namespace ospray {
       switch (key) {
       case '!': {
         if (ImGui3DWidget::animating) {
-          dumpScreensDuringAnimation = !dumpScreensDuringAnimation;
+          toggleRecording();
         } else {
           char tmpFileName[] = "/tmp/ospray_screen_dump_file.XXXXXXXX";
           static const char *dumpFileRoot;
@@ -684,8 +1057,10 @@ namespace ospray {
           char fileName[100000];
           static int frameDumpSequenceID = 0;
           sprintf(fileName,"%s_%05d.ppm",dumpFileRoot,frameDumpSequenceID++);
-          if (ucharFB)
-            saveFrameBufferToFile(fileName,ucharFB,windowSize.x,windowSize.y);
+          if (ucharFB) {
+            saveFrameBufferToFile(imageWriter,fileName,ucharFB,
+                                  frameBufferSize.x,frameBufferSize.y);
+          }
           return;
         }
 
@@ -716,13 +1091,22 @@ namespace ospray {
       case 27 /*ESC*/:
       case 'q':
       case 'Q':
-        std::exit(0);
+        close();
         break;
       default:
         break;
       }
     }
 
+    bool commandLineViewPort(ImGui3DWidget::ViewPort &vp)
+    {
+      if (!viewPortFromCmdLine)
+        return false;
+
+      vp = *viewPortFromCmdLine;
+      return true;
+    }
+
     std::ostream &operator<<(std::ostream &o, const ImGui3DWidget::ViewPort &cam)
     {
       o << "// "
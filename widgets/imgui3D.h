@@ -21,6 +21,8 @@
 #include "ospcommon/AffineSpace.h"
 
 #include "Imgui3dExport.h"
+#include "../common/util/async_image_writer.h"
+#include "../common/util/frame_recorder.h"
 
 class GLFWwindow;
 
@@ -34,6 +36,8 @@ namespace ospray {
     OSPRAY_IMGUI3D_INTERFACE void init(int32_t *ac, const char **av);
     /*! switch over to IMGUI for control flow. This func will not return */
     OSPRAY_IMGUI3D_INTERFACE void run();
+    /*! wake up the UI loop so it redraws; safe to call from any thread */
+    OSPRAY_IMGUI3D_INTERFACE void requestRedraw();
 
     using ospcommon::AffineSpace3fa;
 
@@ -71,7 +75,13 @@ namespace ospray {
       InspectCenter(ImGui3DWidget *widget);
       void rotate(float du, float dv);
 
+      /*! orbit around the given point instead of the viewPort's 'at' */
+      void setPivot(const vec3f &newPivot);
+      void clearPivot();
+      vec3f orbitCenter() const;
+
       vec3f pivot;
+      bool  hasPivot {false};
     };
 
     struct MoveMode : public Manipulator
@@ -166,6 +176,8 @@ namespace ospray {
        // ------------------------------------------------------------------
 
        virtual void motion(const vec2i &pos);
+       /*! 'button', 'action' and 'mods' are the respective GLFW values */
+       virtual void mouseButton(int button, int action, int mods);
        virtual void reshape(const vec2i &newSize);
        /*! display this window. By default this will just clear this
            window's framebuffer; it's up to the user to override this fct
@@ -174,6 +186,10 @@ namespace ospray {
 
        virtual void buildGui();
 
+       /*! whether the UI loop has to keep redrawing even though no input
+           arrived and nobody requested a redraw (e.g. while animating) */
+       virtual bool needsContinuousRedraw() const;
+
        // ------------------------------------------------------------------
        // helper functions
        // ------------------------------------------------------------------
@@ -199,6 +215,10 @@ namespace ospray {
        vec2i lastMousePos; /*! last mouse screen position of mouse before
                              current motion */
        vec2i currMousePos; /*! current screen position of mouse */
+       /*! monotonicTime() of the oldest input event which changed the
+           viewPort but was not handed to the renderer yet (negative if
+           there is none); used to trace input-to-display latency */
+       double pendingInputTime {-1.0};
        int lastButton[3], currButton[3];
        ViewPort viewPort;
        box3f  worldBounds; /*!< world bounds, to automatically set viewPort
@@ -221,24 +241,54 @@ namespace ospray {
        static bool animating;
        static bool showGui;
 
+       /*! block in the UI loop until input arrives or a redraw gets
+           requested, instead of redrawing continuously */
+       static bool idleWhenUnchanged;
+       /*! upper bound (in Hz) on how often the UI redraws while idling */
+       static float maxIdleRedrawRate;
+
        bool renderingPaused {false};
        /*! pointer to the frame buffer data. it is the repsonsiblity of
            the applicatoin derived from this class to properly allocate
            and deallocate the frame buffer pointer */
        union {
          /*! uchar[4] RGBA-framebuffer, if applicable */
-         uint32_t *ucharFB;
+         const uint32_t *ucharFB;
          /*! float[4] RGBA-framebuffer, if applicable */
          vec3fa *floatFB;
        };
+       /*! dimensions of the frame buffer data; it gets stretched to the
+           window if it differs from windowSize */
+       vec2i frameBufferSize;
+       /*! set this whenever the frame buffer data changed; the data only
+           gets streamed to the GPU again when this is set */
+       bool frameBufferUpdated {true};
 
        GLFWwindow *window {nullptr};
 
+       /*! writes screenshots without stalling the UI */
+       async_image_writer imageWriter;
+
+       /*! streams frames to a file or pipe, subclasses submit every newly
+           rendered frame they display */
+       frame_recorder recorder;
+
+       bool startRecording();
+       void stopRecording();
+       void toggleRecording();
+
+       /*! leave run() after the current frame, so that everything still
+           queued (screenshots, recordings) gets written out */
+       void close();
+
        virtual void keypress(char key);
     };
 
     OSPRAY_IMGUI3D_INTERFACE std::ostream &operator<<(std::ostream &o,
                                             const ImGui3DWidget::ViewPort &cam);
+
+    /*! get the viewport given on the command line (-vp/-vi/-vu/-v), if any */
+    OSPRAY_IMGUI3D_INTERFACE bool commandLineViewPort(ImGui3DWidget::ViewPort &vp);
   }
 }
 
@@ -18,31 +18,18 @@
 #include "imguiViewer.h"
 
 #include <imgui.h>
+#include <GLFW/glfw3.h>
+
+#include <cmath>
 
 using std::string;
 using namespace ospcommon;
 
-// Static local helper functions //////////////////////////////////////////////
-
-// helper function to write the rendered image as PPM file
-static void writePPM(const string &fileName, const int sizeX, const int sizeY,
-                     const uint32_t *pixel)
-{
-  FILE *file = fopen(fileName.c_str(), "wb");
-  fprintf(file, "P6\n%i %i\n255\n", sizeX, sizeY);
-  unsigned char *out = (unsigned char *)alloca(3*sizeX);
-  for (int y = 0; y < sizeY; y++) {
-    const unsigned char *in = (const unsigned char *)&pixel[(sizeY-1-y)*sizeX];
-    for (int x = 0; x < sizeX; x++) {
-      out[3*x + 0] = in[4*x + 0];
-      out[3*x + 1] = in[4*x + 1];
-      out[3*x + 2] = in[4*x + 2];
-    }
-    fwrite(out, 3*sizeX, sizeof(char), file);
-  }
-  fprintf(file, "\n");
-  fclose(file);
-}
+// how long after the last camera change the governor keeps trading quality
+// for frame time
+static const double governorHoldTime = 0.5;
+
+static const char *cameraPathFile = "ospimguiviewer_camera.path";
 
 // ImGuiViewer definitions ////////////////////////////////////////////////////
 
@@ -69,6 +56,12 @@ ImGuiViewer::ImGuiViewer(const std::deque<box3f> &worldBounds,
   renderEngine.setFbSize({1024, 768});
 
   renderEngine.scheduleObjectCommit(renderer);
+  renderEngine.setFramePublishedCallback(imgui3D::requestRedraw);
+  renderEngine.setDepthCapture(true);
+
+  appliedQuality = userQuality;
+  governor.setFullQuality(userQuality);
+  governor.setTargetFrameTime(1.0 / targetFps);
   renderEngine.start();
 
   frameTimer = ospcommon::getSysTime();
@@ -78,11 +71,63 @@ ImGuiViewer::ImGuiViewer(const std::deque<box3f> &worldBounds,
   animationPaused = false;
   originalView = viewPort;
   scale = vec3f(1,1,1);
+
+  startPrefetcher();
 }
 
 ImGuiViewer::~ImGuiViewer()
 {
+  prefetcher.stop();
   renderEngine.stop();
+  releaseCompositeModels();
+}
+
+void ImGuiViewer::setScale(const vec3f& v)
+{
+  prefetcher.stop();
+  scale = v;
+  releaseCompositeModels();
+  startPrefetcher();
+}
+
+void ImGuiViewer::setTranslation(const vec3f& v)
+{
+  prefetcher.stop();
+  translate = v;
+  releaseCompositeModels();
+  startPrefetcher();
+}
+
+void ImGuiViewer::releaseCompositeModels()
+{
+  // NOTE: the renderer keeps its own reference to the model it is using
+  for (auto &m : compositeModels) {
+    if (m.handle())
+      ospRelease(m.object());
+  }
+
+  compositeModels.clear();
+}
+
+void ImGuiViewer::setLockFirstAnimationFrame(bool st)
+{
+  prefetcher.stop();
+  lockFirstAnimationFrame = st;
+  startPrefetcher();
+}
+
+void ImGuiViewer::setTimestepCache(std::shared_ptr<timestep_cache> cache)
+{
+  prefetcher.stop();
+  timesteps = cache;
+  if (timesteps)
+    timesteps->setMinResident(prefetchTimesteps + 2);
+  startPrefetcher();
+}
+
+size_t ImGuiViewer::numTimesteps() const
+{
+  return timesteps ? timesteps->size() : sceneModels.size();
 }
 
 void ImGuiViewer::setRenderer(OSPRenderer renderer)
@@ -99,7 +144,6 @@ void ImGuiViewer::reshape(const vec2i &newSize)
   viewPort.modified = true;
 
   renderEngine.setFbSize(newSize);
-  pixelBuffer.resize(newSize.x * newSize.y);
 }
 
 void ImGuiViewer::keypress(char key)
@@ -153,22 +197,70 @@ void ImGuiViewer::keypress(char key)
   case 'p':
     printViewport();
     break;
+  case 'K':
+    toggleCameraPathRecording();
+    break;
+  case 'P':
+    replayingCameraPath ? stopCameraPathReplay() : startCameraPathReplay();
+    break;
   case 27 /*ESC*/:
   case 'q':
   case 'Q':
-    renderEngine.stop();
-    std::exit(0);
+    close();
     break;
   default:
     ImGui3DWidget::keypress(key);
   }
 }
 
+void ImGuiViewer::mouseButton(int button, int action, int mods)
+{
+  ImGui3DWidget::mouseButton(button, action, mods);
+
+  const bool ctrlClick = button == GLFW_MOUSE_BUTTON_LEFT &&
+                         action == GLFW_PRESS && (mods & GLFW_MOD_CONTROL);
+
+  if (ctrlClick && !ImGui::GetIO().WantCaptureMouse)
+    pickOrbitPivot(currMousePos);
+}
+
 void ImGuiViewer::resetView()
 {
   auto oldAspect = viewPort.aspect;
   viewPort = originalView;
   viewPort.aspect = oldAspect;
+  ((imgui3D::InspectCenter*)inspectCenterManipulator)->clearPivot();
+}
+
+bool ImGuiViewer::pickOrbitPivot(const vec2i &pos)
+{
+  if (!currentFrame || currentFrame->depth.empty())
+    return false;
+
+  // NOTE: cursor positions are in window (not frame buffer) coordinates,
+  //       with the origin at the top left
+  int width = 0, height = 0;
+  glfwGetWindowSize(window, &width, &height);
+  if (width <= 0 || height <= 0)
+    return false;
+
+  const vec2f screen((pos.x + 0.5f) / width, 1.f - (pos.y + 0.5f) / height);
+
+  auto &size = currentFrame->size;
+  const int px = std::min(std::max(int(screen.x * size.x), 0), size.x - 1);
+  const int py = std::min(std::max(int(screen.y * size.y), 0), size.y - 1);
+
+  const float depth = currentFrame->depth[py * size.x + px];
+  if (!std::isfinite(depth))
+    return false;
+
+  const auto *frameView = viewOf(*currentFrame);
+  const auto  view      = frameView ? *frameView : currentView();
+
+  auto *orbit = (imgui3D::InspectCenter*)inspectCenterManipulator;
+  orbit->setPivot(unprojectPixel(view, screen, depth));
+
+  return true;
 }
 
 void ImGuiViewer::printViewport()
@@ -182,8 +274,45 @@ void ImGuiViewer::printViewport()
 
 void ImGuiViewer::saveScreenshot(const std::string &basename)
 {
-  writePPM(basename + ".ppm", windowSize.x, windowSize.y, pixelBuffer.data());
-  std::cout << "saved current frame to '" << basename << ".ppm'" << std::endl;
+  // NOTE: preview frames are rendered at reduced resolution, and frames
+  //       older than the current camera are only shown warped, so wait for
+  //       a full-resolution frame of the current view instead
+  const bool fullFrame = currentFrame && currentFrame->accumulated > 0 &&
+                         currentFrame->generation >= cameraGeneration;
+  if (!fullFrame) {
+    pendingScreenshot = basename;
+    return;
+  }
+
+  pendingScreenshot.clear();
+
+  // NOTE: share the frame's pixels with the writer instead of copying them,
+  //       the engine never touches a frame while a handle to it is alive
+  auto pixels = std::shared_ptr<const std::vector<uint32_t>>(
+      currentFrame, &currentFrame->color);
+
+  auto fileName = basename + ".png";
+  if (!imageWriter.write(fileName, ImageFormat::PNG, currentFrame->size,
+                         std::move(pixels))) {
+    std::cerr << "too many screenshots pending, dropped '" << fileName << "'"
+              << std::endl;
+  }
+}
+
+void ImGuiViewer::saveFloatScreenshot(const std::string &basename)
+{
+  renderEngine.requestFloatCapture(
+    [=](const vec2i &size, async_render_engine::FloatPixels pixels) {
+      for (auto format : {ImageFormat::PFM, ImageFormat::EXR}) {
+        auto fileName =
+            basename + (format == ImageFormat::PFM ? ".pfm" : ".exr");
+        if (!imageWriter.write(fileName, format, size, pixels)) {
+          std::cerr << "too many screenshots pending, dropped '" << fileName
+                    << "'" << std::endl;
+        }
+      }
+    }
+  );
 }
 
 void ImGuiViewer::toggleRenderingPaused()
@@ -192,11 +321,131 @@ void ImGuiViewer::toggleRenderingPaused()
   renderingPaused ? renderEngine.stop() : renderEngine.start();
 }
 
+void ImGuiViewer::applyQuality(const QualitySettings &quality)
+{
+  if (quality.aoSamples != appliedQuality.aoSamples) {
+    renderEngine.scheduleParamChange(renderer, "aoSamples", quality.aoSamples);
+  }
+
+  if (quality.spp != appliedQuality.spp)
+    renderEngine.scheduleParamChange(renderer, "spp", quality.spp);
+
+  if (quality.shadows != appliedQuality.shadows) {
+    renderEngine.scheduleParamChange(renderer, "shadowsEnabled",
+                                     int(quality.shadows));
+  }
+
+  if (quality.previewScale != appliedQuality.previewScale)
+    renderEngine.setPreviewScale(quality.previewScale);
+
+  appliedQuality = quality;
+}
+
+void ImGuiViewer::toggleCameraPathRecording()
+{
+  if (replayingCameraPath)
+    return;
+
+  recordingCameraPath = !recordingCameraPath;
+
+  if (recordingCameraPath) {
+    cameraPath.clear();
+    cameraPathStart   = monotonicTime();
+    viewPort.modified = true; // record the view we start from
+  } else if (cameraPath.save(cameraPathFile)) {
+    std::cout << "saved " << cameraPath.size() << " camera keyframes to '"
+              << cameraPathFile << "'" << std::endl;
+  } else {
+    std::cerr << "failed to write '" << cameraPathFile << "'" << std::endl;
+  }
+}
+
+void ImGuiViewer::startCameraPathReplay()
+{
+  if (recordingCameraPath)
+    toggleCameraPathRecording();
+
+  if (cameraPath.empty() && !cameraPath.load(cameraPathFile)) {
+    std::cerr << "no camera path to replay, failed to read '"
+              << cameraPathFile << "'" << std::endl;
+    return;
+  }
+
+  replayingCameraPath     = true;
+  replayKeyframe          = 0;
+  replayKeyframeScheduled = false;
+  replayKeyframeTimes.clear();
+
+  // NOTE: every keyframe gets rendered the same way, so nothing that adapts
+  //       to the frame rate may be active while replaying
+  animating = false;
+  applyQuality(userQuality);
+  renderEngine.setPreviewScale(1);
+  renderEngine.setMaxAccumFrames(replayFramesPerKeyframe);
+}
+
+void ImGuiViewer::stopCameraPathReplay()
+{
+  if (!replayingCameraPath)
+    return;
+
+  replayingCameraPath = false;
+
+  renderEngine.setMaxAccumFrames(maxAccumFrames);
+  renderEngine.setPreviewScale(appliedQuality.previewScale);
+  applyQuality(governQuality ? governor.current() : userQuality);
+
+  printReplayReport(stdout, cameraPath, replayKeyframeTimes,
+                    replayFramesPerKeyframe);
+}
+
+void ImGuiViewer::advanceCameraPathReplay()
+{
+  // NOTE: a keyframe is done once a frame rendered with its camera has
+  //       accumulated all of its samples; its time runs from scheduling the
+  //       camera to that frame being finished, so display isn't counted
+  if (!replayKeyframeScheduled ||
+      currentFrame->generation < replayGeneration ||
+      currentFrame->accumulated < replayFramesPerKeyframe) {
+    return;
+  }
+
+  replayKeyframeTimes.push_back(currentFrame->doneTime - replayKeyframeStart);
+  replayKeyframeScheduled = false;
+
+  if (++replayKeyframe == cameraPath.size())
+    stopCameraPathReplay();
+}
+
+PerspectiveView ImGuiViewer::currentView() const
+{
+  PerspectiveView view;
+  view.pos    = viewPort.from;
+  view.dir    = viewPort.at - viewPort.from;
+  view.up     = viewPort.up;
+  view.fovy   = viewPort.openingAngle;
+  view.aspect = viewPort.aspect;
+  return view;
+}
+
+const PerspectiveView *ImGuiViewer::viewOf(const RenderedFrame &frame)
+{
+  auto view = viewHistory.upper_bound(frame.generation);
+  if (view == viewHistory.begin())
+    return nullptr;
+
+  --view;
+
+  // NOTE: frames only ever get newer, so older views are no longer needed
+  viewHistory.erase(viewHistory.begin(), view);
+
+  return &view->second;
+}
+
 void ImGuiViewer::setWorldBounds(const box3f &worldBounds) {
   ImGui3DWidget::setWorldBounds(worldBounds);
   aoDistance = (worldBounds.upper.x - worldBounds.lower.x)/4.f;
-  renderer.set("aoDistance", aoDistance);
-  renderEngine.scheduleObjectCommit(renderer);
+  renderEngine.scheduleParamChange(renderer, "aoDistance", aoDistance);
 }
 
 void ImGuiViewer::display()
@@ -204,89 +453,268 @@ void ImGuiViewer::display()
   updateAnimation(ospcommon::getSysTime()-frameTimer);
   frameTimer = ospcommon::getSysTime();
 
+  const bool scheduleKeyframe = replayingCameraPath && !replayKeyframeScheduled;
+  if (scheduleKeyframe) {
+    auto &keyframe = cameraPath[replayKeyframe];
+    setViewPort(keyframe.from, keyframe.at, keyframe.up);
+    viewPort.openingAngle = keyframe.fovy;
+  }
+
   if (viewPort.modified) {
     Assert2(camera.handle(),"ospray camera is null");
-    camera.set("pos", viewPort.from);
+
+    // NOTE: viewport changes not caused by mouse motion (keys, menus,
+    //       auto-rotate) are stamped when we first see them
+    auto inputTime = pendingInputTime >= 0.0 ? pendingInputTime
+                                             : monotonicTime();
+
+    renderEngine.scheduleParamChange(camera, "pos", viewPort.from);
     auto dir = viewPort.at - viewPort.from;
-    camera.set("dir", dir);
-    camera.set("up", viewPort.up);
-    camera.set("aspect", viewPort.aspect);
-    camera.set("fovy", viewPort.openingAngle);
+    renderEngine.scheduleParamChange(camera, "dir", dir);
+    renderEngine.scheduleParamChange(camera, "up", viewPort.up);
+    renderEngine.scheduleParamChange(camera, "aspect", viewPort.aspect);
+    auto generation =
+        renderEngine.scheduleParamChange(camera, "fovy", viewPort.openingAngle);
+
+    latency.inputScheduled(generation, inputTime);
+    pendingInputTime = -1.0;
+
+    viewHistory[generation] = currentView();
+    cameraGeneration = generation;
+
+    // NOTE: only frames that are still in flight need their views kept
+    while (viewHistory.size() > MAX_VIEW_HISTORY)
+      viewHistory.erase(viewHistory.begin());
+
+    if (recordingCameraPath) {
+      CameraKeyframe keyframe;
+      keyframe.time = inputTime - cameraPathStart;
+      keyframe.from = viewPort.from;
+      keyframe.at   = viewPort.at;
+      keyframe.up   = viewPort.up;
+      keyframe.fovy = viewPort.openingAngle;
+      cameraPath.add(keyframe);
+    }
+
+    if (scheduleKeyframe) {
+      replayGeneration        = generation;
+      replayKeyframeStart     = monotonicTime();
+      replayKeyframeScheduled = true;
+    }
 
     viewPort.modified = false;
-    renderEngine.scheduleObjectCommit(camera);
+    renderEngine.notifyInteraction();
+    lastInteractionTime = monotonicTime();
   }
 
+  bool newFrame = false;
   if (renderEngine.hasNewFrame()) {
-    auto &mappedFB = renderEngine.mapFramebuffer();
-    auto nPixels = windowSize.x * windowSize.y;
-
-    if (mappedFB.size() == nPixels) {
-      auto *srcPixels = mappedFB.data();
-      auto *dstPixels = pixelBuffer.data();
-      memcpy(dstPixels, srcPixels, nPixels * sizeof(uint32_t));
-      lastFrameFPS = renderEngine.lastFrameFps();
+    auto frame   = renderEngine.acquireFrame();
+    lastFrameFPS = renderEngine.lastFrameFps();
+
+    // NOTE: always take the newest frame, even one rendered with an older
+    //       camera; it's still closer to the current view than the frame
+    //       shown so far, and gets warped over to the current view below
+    if (frame) {
+      currentFrame = frame;
+      newFrame     = true;
     }
+  }
+
+  if (replayingCameraPath && newFrame)
+    advanceCameraPathReplay();
+
+  if (governQuality && !replayingCameraPath) {
+    auto interacting =
+        monotonicTime() - lastInteractionTime < governorHoldTime;
 
-    renderEngine.unmapFramebuffer();
+    bool qualityChanged = governor.setInteracting(interacting);
+    if (newFrame)
+      qualityChanged |= governor.update(renderEngine.lastFrameRenderTime());
+
+    if (qualityChanged)
+      applyQuality(governor.current());
+  }
+
+  // NOTE: upload straight from the engine-owned frame, which stays valid for
+  //       as long as we hold on to its handle; preview frames are smaller
+  //       than the window and get upscaled on display
+  if (currentFrame) {
+    ucharFB = currentFrame->color.data();
+    frameBufferSize = currentFrame->size;
+    frameBufferUpdated |= newFrame;
+
+    // NOTE: until a frame rendered with the latest camera shows up, warp the
+    //       last one we got over to that camera
+    bool outdated = currentFrame->generation < cameraGeneration;
+    const PerspectiveView *frameView = nullptr;
+
+    if (reprojectFrames && outdated && !currentFrame->depth.empty())
+      frameView = viewOf(*currentFrame);
+
+    if (frameView) {
+      // NOTE: warping is a full pass over the frame, only redo it when the
+      //       frame or the view it's warped to changed
+      const auto view = currentView();
+      if (!showingReprojection || currentFrame->id != warpedFrameId ||
+          view != warpedView) {
+        warped = &reprojector.reproject(currentFrame->size,
+                                        currentFrame->color.data(),
+                                        currentFrame->depth.data(),
+                                        *frameView, view);
+        warpedFrameId = currentFrame->id;
+        warpedView    = view;
+        frameBufferUpdated = true;
+      }
+
+      ucharFB = warped->data();
+      showingReprojection = true;
+    } else if (showingReprojection) {
+      frameBufferUpdated = true;
+      showingReprojection = false;
+    }
   }
 
-  ucharFB = pixelBuffer.data();
   frameBufferMode = ImGui3DWidget::FRAMEBUFFER_UCHAR;
+
+  auto uploadStart = ospcommon::getSysTime();
   ImGui3DWidget::display();
 
+  if (newFrame && !pendingScreenshot.empty())
+    saveScreenshot(pendingScreenshot);
+
+  // NOTE: only frames the renderer produced get recorded, not the warped or
+  //       repeated ones shown in between
+  if (newFrame && recorder.isRecording())
+    recorder.submit(currentFrame->color.data(), currentFrame->size);
+
+  if (newFrame) {
+    renderEngine.recordUploadTime(currentFrame->id,
+                                  ospcommon::getSysTime() - uploadStart);
+    latency.frameDisplayed(currentFrame->generation,
+                           currentFrame->commitTime,
+                           currentFrame->doneTime,
+                           monotonicTime());
+  }
+
   // that pointer is no longer valid, so set it to null
   ucharFB = nullptr;
+
+  if (newFrame && !firstFrameDisplayed) {
+    firstFrameDisplayed = true;
+
+    auto &profiler = startup_profiler::instance();
+    profiler.mark("first frame displayed");
+    if (profiler.finish())
+      close();
+  }
 }
 
 void ImGuiViewer::updateAnimation(double deltaSeconds)
 {
-  if (sceneModels.size() < 2)
+  if (numTimesteps() < 2)
     return;
   if (animationPaused)
     return;
   animationTimer += deltaSeconds;
-  int framesSize = sceneModels.size();
+  int framesSize = numTimesteps();
   const int frameStart = (lockFirstAnimationFrame ? 1 : 0);
   if (lockFirstAnimationFrame)
     framesSize--;
 
   if (animationTimer > animationFrameDelta)
   {
+    size_t dataFrameId = (animationFrameId+1)%framesSize+frameStart;
+
+    // NOTE: hold the current timestep until the next one has been prepared,
+    //       so the render thread never waits on building a model
+    cpp::Model nextModel(nullptr);
+    if (!prefetcher.fetch(dataFrameId, nextModel)) {
+      prefetchAfter(animationFrameId);
+      return;
+    }
+
     animationFrameId++;
 
     //set animation time to remainder off of delta 
     animationTimer -= int(animationTimer/deltaSeconds) * deltaSeconds;
 
-    size_t dataFrameId = animationFrameId%framesSize+frameStart;
-    if (lockFirstAnimationFrame)
-    {
-      ospcommon::affine3f xfm = ospcommon::one;
-      xfm *= ospcommon::affine3f::translate(translate)
-             * ospcommon::affine3f::scale(scale);
-      OSPGeometry dynInst =
-              ospNewInstance((OSPModel)sceneModels[dataFrameId].object(),
-              (osp::affine3f&)xfm);
-      ospray::cpp::Model worldModel = ospNewModel();
-      ospcommon::affine3f staticXFM = ospcommon::one;
-      OSPGeometry staticInst =
-              ospNewInstance((OSPModel)sceneModels[0].object(),
-              (osp::affine3f&)staticXFM);
-      //Carson: TODO: creating new world model every frame unecessary
-      worldModel.addGeometry(staticInst);
-      worldModel.addGeometry(dynInst);
-      worldModel.commit();
-      renderer.set("model",  worldModel);
-    }
-    else
-    {
-      renderer.set("model",  sceneModels[dataFrameId]);
-    }
-
-    renderEngine.scheduleObjectCommit(renderer);
+    // NOTE: a timestep that failed to load is skipped
+    if (nextModel.handle())
+      renderEngine.scheduleParamChange(renderer, "model", nextModel);
+    prefetchAfter(animationFrameId);
   }
 }
 
+void ImGuiViewer::startPrefetcher()
+{
+  if (numTimesteps() < 2)
+    return;
+
+  // NOTE: the prefetcher is stopped whenever the settings used here change,
+  //       so the worker is the only one touching them while it runs
+  prefetcher.start([&](size_t dataFrameId) {
+    if (timesteps)
+      return timesteps->acquire(dataFrameId);
+
+    return lockFirstAnimationFrame ? compositeModel(dataFrameId)
+                                   : sceneModels[dataFrameId];
+  });
+}
+
+void ImGuiViewer::prefetchAfter(size_t frameId)
+{
+  int framesSize = numTimesteps();
+  const int frameStart = (lockFirstAnimationFrame ? 1 : 0);
+  if (lockFirstAnimationFrame)
+    framesSize--;
+
+  std::vector<size_t> upcoming;
+  for (int i = 1; i <= std::min(prefetchTimesteps, framesSize); ++i)
+    upcoming.push_back((frameId+i)%framesSize+frameStart);
+
+  prefetcher.request(upcoming);
+}
+
+cpp::Model ImGuiViewer::compositeModel(size_t dataFrameId)
+{
+  if (compositeModels.size() != sceneModels.size())
+    compositeModels.assign(sceneModels.size(), cpp::Model(nullptr));
+
+  auto &worldModel = compositeModels[dataFrameId];
+  if (worldModel.handle())
+    return worldModel;
+
+  ospcommon::affine3f xfm = ospcommon::one;
+  xfm *= ospcommon::affine3f::translate(translate)
+         * ospcommon::affine3f::scale(scale);
+  OSPGeometry dynInst =
+          ospNewInstance((OSPModel)sceneModels[dataFrameId].object(),
+          (osp::affine3f&)xfm);
+  ospcommon::affine3f staticXFM = ospcommon::one;
+  OSPGeometry staticInst =
+          ospNewInstance((OSPModel)sceneModels[0].object(),
+          (osp::affine3f&)staticXFM);
+
+  worldModel = ospNewModel();
+  worldModel.addGeometry(staticInst);
+  worldModel.addGeometry(dynInst);
+  worldModel.commit();
+
+  // NOTE: the model keeps its own references to the instances
+  ospRelease(staticInst);
+  ospRelease(dynInst);
+
+  return worldModel;
+}
+
+bool ImGuiViewer::needsContinuousRedraw() const
+{
+  const bool playingAnimation = numTimesteps() > 1 && !animationPaused;
+  return ImGui3DWidget::needsContinuousRedraw() || playingAnimation ||
+         replayingCameraPath;
+}
+
 void ImGuiViewer::buildGui()
 {
   ImGuiWindowFlags flags = ImGuiWindowFlags_MenuBar;
@@ -308,11 +736,16 @@ void ImGuiViewer::buildGui()
       if (ImGui::Checkbox("Pause Rendering", &paused)) {
         toggleRenderingPaused();
       }
+      ImGui::Checkbox("Idle When Unchanged", &idleWhenUnchanged);
+      ImGui::SliderFloat("Max Idle Redraw Rate (Hz)", &maxIdleRedrawRate,
+                         0.5f, 60.f);
       if (ImGui::MenuItem("Take Screenshot")) saveScreenshot("ospimguiviewer");
-      if (ImGui::MenuItem("Quit")) {
-        renderEngine.stop();
-        std::exit(0);
-      }
+      if (ImGui::MenuItem("Take Float Screenshot (PFM + EXR)"))
+        saveFloatScreenshot("ospimguiviewer");
+      bool recording = recorder.isRecording();
+      if (ImGui::Checkbox("Record Frames", &recording))
+        toggleRecording();
+      if (ImGui::MenuItem("Quit")) close();
       ImGui::EndMenu();
     }
 
@@ -328,7 +761,12 @@ void ImGuiViewer::buildGui()
         manipulator = moveModeManipulator;
       }
 
+      ImGui::Checkbox("Reproject Last Frame", &reprojectFrames);
+
       if (ImGui::MenuItem("Reset View")) resetView();
+      if (ImGui::MenuItem("Clear Orbit Pivot")) {
+        ((imgui3D::InspectCenter*)inspectCenterManipulator)->clearPivot();
+      }
       if (ImGui::MenuItem("Reset Accumulation")) viewPort.modified = true;
       if (ImGui::MenuItem("Print View")) printViewport();
 
@@ -346,6 +784,149 @@ void ImGuiViewer::buildGui()
     ImGui::Text("OSPRay render rate: %.1f FPS", lastFrameFPS);
     ImGui::Text("  GUI display rate: %.1f FPS", ImGui::GetIO().Framerate);
     ImGui::NewLine();
+    ImGui::Text("accumulated frames: %i", renderEngine.accumulatedFrames());
+    ImGui::Text("  running variance: %.5f", renderEngine.estimatedVariance());
+    ImGui::Text("commits last frame: %i", renderEngine.lastFrameCommits());
+
+    if (recorder.isRecording()) {
+      auto stats = recorder.stats();
+      ImGui::NewLine();
+      ImGui::Text("   recorded frames: %i", int(stats.written));
+      ImGui::Text("    dropped frames: %i", int(stats.dropped));
+      ImGui::Text("    blocked frames: %i", int(stats.blocked));
+    }
+    ImGui::NewLine();
+  }
+
+  if (ImGui::CollapsingHeader("Frame Timings"))
+  {
+    auto history = renderEngine.timingHistory();
+
+    FrameTiming avg;
+    int numUploads = 0;
+    std::vector<float> renderTimes;
+    renderTimes.reserve(history.size());
+
+    for (auto &t : history) {
+      avg.commit  += t.commit;
+      avg.resize  += t.resize;
+      avg.render  += t.render;
+      avg.map     += t.map;
+      avg.copy    += t.copy;
+      avg.publish += t.publish;
+      avg.upload  += t.upload;
+      numUploads  += t.upload > 0.0 ? 1 : 0;
+      renderTimes.push_back(t.render * 1000.f);
+    }
+
+    // NOTE: report averages in milliseconds
+    auto scale = history.empty() ? 0.0 : 1000.0 / history.size();
+
+    ImGui::NewLine();
+    ImGui::Text("average over the last %i frames:", int(history.size()));
+    ImGui::Text("   commit: %.3f ms", avg.commit  * scale);
+    ImGui::Text("   resize: %.3f ms", avg.resize  * scale);
+    ImGui::Text("   render: %.3f ms", avg.render  * scale);
+    ImGui::Text("      map: %.3f ms", avg.map     * scale);
+    ImGui::Text("     copy: %.3f ms", avg.copy    * scale);
+    ImGui::Text("  publish: %.3f ms", avg.publish * scale);
+    ImGui::Text("   upload: %.3f ms (%i frames displayed)",
+                numUploads ? avg.upload * 1000.0 / numUploads : 0.0,
+                numUploads);
+
+    if (!renderTimes.empty()) {
+      ImGui::PlotLines("render (ms)", renderTimes.data(),
+                       int(renderTimes.size()));
+    }
+
+    if (ImGui::Button("Dump Timings to CSV")) {
+      const std::string fileName = "ospimguiviewer_timings.csv";
+      if (renderEngine.dumpTimingsCSV(fileName))
+        std::cout << "saved frame timings to '" << fileName << "'" << std::endl;
+      else
+        std::cerr << "failed to write '" << fileName << "'" << std::endl;
+    }
+
+    ImGui::NewLine();
+  }
+
+  if (ImGui::CollapsingHeader("Input Latency"))
+  {
+    auto summary = latency.summary();
+
+    auto showStats = [](const char *label, const LatencyStats &stats) {
+      ImGui::Text("%s %7.2f %7.2f %7.2f %7.2f", label,
+                  stats.p50 * 1000.0, stats.p95 * 1000.0,
+                  stats.p99 * 1000.0, stats.max * 1000.0);
+    };
+
+    ImGui::NewLine();
+    ImGui::Text("last %i camera changes (ms):", int(summary.numSamples));
+    ImGui::Text("                      p50     p95     p99     max");
+    showStats("  input -> commit", summary.inputToCommit);
+    showStats(" commit -> done  ", summary.commitToDone);
+    showStats("   done -> shown ", summary.doneToDisplay);
+    showStats("  input -> shown ", summary.total);
+
+    if (ImGui::Button("Dump Latencies to CSV")) {
+      const std::string fileName = "ospimguiviewer_latency.csv";
+      if (latency.dumpCSV(fileName))
+        std::cout << "saved input latencies to '" << fileName << "'" << std::endl;
+      else
+        std::cerr << "failed to write '" << fileName << "'" << std::endl;
+    }
+
+    ImGui::NewLine();
+  }
+
+  if (ImGui::CollapsingHeader("Camera Path"))
+  {
+    ImGui::NewLine();
+
+    bool recording = recordingCameraPath;
+    if (ImGui::Checkbox("record camera path ('K')", &recording))
+      toggleCameraPathRecording();
+
+    ImGui::InputInt("frames per keyframe", &replayFramesPerKeyframe, 1, 16);
+    replayFramesPerKeyframe = std::max(replayFramesPerKeyframe, 1);
+
+    if (ImGui::Button("Load Path")) {
+      if (!cameraPath.load(cameraPathFile))
+        std::cerr << "failed to read '" << cameraPathFile << "'" << std::endl;
+    }
+
+    ImGui::SameLine();
+    if (!replayingCameraPath && ImGui::Button("Replay Path ('P')"))
+      startCameraPathReplay();
+    else if (replayingCameraPath && ImGui::Button("Stop Replay ('P')"))
+      stopCameraPathReplay();
+
+    ImGui::Text("keyframes: %i", int(cameraPath.size()));
+    if (replayingCameraPath) {
+      ImGui::Text("replaying keyframe %i of %i", int(replayKeyframe + 1),
+                  int(cameraPath.size()));
+    }
+
+    ImGui::NewLine();
+  }
+
+  if (timesteps && ImGui::CollapsingHeader("Timestep Streaming"))
+  {
+    ImGui::NewLine();
+
+    const float MB = 1024.f * 1024.f;
+
+    int budgetMB = int(timesteps->budget() / MB);
+    if (ImGui::InputInt("memory budget (MB)", &budgetMB, 64, 1024))
+      timesteps->setBudget(size_t(std::max(budgetMB, 0)) * size_t(MB));
+
+    ImGui::Text("resident: %i of %i timesteps, %.1f MB",
+                int(timesteps->numResident()), int(timesteps->size()),
+                timesteps->residentBytes() / MB);
+    ImGui::Text("loads: %i  evictions: %i", int(timesteps->numLoads()),
+                int(timesteps->numEvictions()));
+
+    ImGui::NewLine();
   }
 
   if (ImGui::CollapsingHeader("Renderer Parameters"))
@@ -359,57 +940,82 @@ void ImGuiViewer::buildGui()
       renderer_changed = true;
     }
 
-    static int ao = 1;
-    if (ImGui::SliderInt("aoSamples", &ao, 0, 32)) {
-      renderer.set("aoSamples", ao);
-      renderer_changed = true;
-    }
+    bool quality_changed = false;
+
+    quality_changed |=
+        ImGui::SliderInt("aoSamples", &userQuality.aoSamples, 0, 32);
 
     if (ImGui::InputFloat("aoDistance", &aoDistance)) {
-      renderer.set("aoDistance", aoDistance);
-      renderer_changed = true;
+      renderEngine.scheduleParamChange(renderer, "aoDistance", aoDistance);
     }
 
     static bool ao_transparency = false;
     if (ImGui::Checkbox("ao transparency", &ao_transparency)) {
-      renderer.set("aoTransparencyEnabled", int(ao_transparency));
-      renderer_changed = true;
+      renderEngine.scheduleParamChange(renderer, "aoTransparencyEnabled",
+                                       int(ao_transparency));
     }
 
-    static bool shadows = true;
-    if (ImGui::Checkbox("shadows", &shadows)) {
-      renderer.set("shadowsEnabled", int(shadows));
-      renderer_changed = true;
-    }
+    quality_changed |= ImGui::Checkbox("shadows", &userQuality.shadows);
 
     static bool singleSidedLighting = true;
     if (ImGui::Checkbox("single_sided_lighting", &singleSidedLighting)) {
-      renderer.set("oneSidedLighting", int(singleSidedLighting));
-      renderer_changed = true;
+      renderEngine.scheduleParamChange(renderer, "oneSidedLighting",
+                                       int(singleSidedLighting));
     }
 
     static int exponent = -6;
     if (ImGui::SliderInt("ray_epsilon (exponent)", &exponent, -10, 2)) {
-      renderer.set("epsilon", ospcommon::pow(10.f, (float)exponent));
-      renderer_changed = true;
+      renderEngine.scheduleParamChange(renderer, "epsilon",
+                                       ospcommon::pow(10.f, (float)exponent));
     }
 
-    static int spp = 1;
-    if (ImGui::SliderInt("spp", &spp, -4, 16)) {
-      renderer.set("spp", spp);
-      renderer_changed = true;
+    if (ImGui::Combo("preview resolution", &previewLevel,
+                     "full\0" "1/2\0" "1/4\0" "1/8\0\0")) {
+      userQuality.previewScale = 1 << previewLevel;
+      quality_changed = true;
     }
 
+    if (ImGui::InputInt("max accumulation (0 = off)", &maxAccumFrames, 1, 16)
+        && !replayingCameraPath) {
+      renderEngine.setMaxAccumFrames(maxAccumFrames);
+    }
+
+    static float varianceThreshold = 0.f;
+    if (ImGui::InputFloat("variance threshold (0 = off)", &varianceThreshold,
+                          0.001f, 0.01f, 4)) {
+      renderEngine.setVarianceThreshold(varianceThreshold);
+    }
+
+    quality_changed |= ImGui::SliderInt("spp", &userQuality.spp, -4, 16);
+
     static ImVec4 bg_color = ImColor(255, 255, 255);
     if (ImGui::ColorEdit3("bg_color", (float*)&bg_color)) {
-      renderer.set("bgColor", bg_color.x, bg_color.y, bg_color.z);
-      renderer_changed = true;
+      renderEngine.scheduleParamChange(renderer, "bgColor",
+                                       vec3f(bg_color.x, bg_color.y,
+                                             bg_color.z));
+    }
+
+    if (quality_changed) {
+      governor.setFullQuality(userQuality);
+      applyQuality(governQuality ? governor.current() : userQuality);
     }
 
     if (renderer_changed)
       renderEngine.scheduleObjectCommit(renderer);
   }
 
+  if (ImGui::CollapsingHeader("Frame Time Governor"))
+  {
+    if (ImGui::Checkbox("hold target frame rate", &governQuality))
+      applyQuality(governQuality ? governor.current() : userQuality);
+
+    if (ImGui::SliderFloat("target FPS", &targetFps, 1.f, 120.f))
+      governor.setTargetFrameTime(1.0 / targetFps);
+
+    ImGui::Text("quality level: %i (0 = full, %i = lowest)",
+                governor.level(), quality_governor::MAX_LEVEL);
+  }
+
   ImGui::End();
 }
 
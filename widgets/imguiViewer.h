@@ -27,11 +27,18 @@
 #include <ospray/ospray_cpp/Renderer.h>
 
 #include "../common/util/async_render_engine.h"
+#include "../common/util/camera_path.h"
+#include "../common/util/frame_reprojector.h"
+#include "../common/util/quality_governor.h"
+#include "../common/util/startup_profiler.h"
+#include "../common/util/timestep_cache.h"
+#include "../common/util/timestep_prefetcher.h"
 
 #include "imgui3D.h"
 #include "Imgui3dExport.h"
 
 #include <deque>
+#include <map>
 
 namespace ospray {
 
@@ -50,19 +57,36 @@ namespace ospray {
     ~ImGuiViewer();
 
     void setRenderer(OSPRenderer renderer);
-    void setScale(const ospcommon::vec3f& v )  {scale = v;}
-    void setTranslation(const ospcommon::vec3f& v)  {translate = v;}
-    void setLockFirstAnimationFrame(bool st) {lockFirstAnimationFrame = st;}
+    void setScale(const ospcommon::vec3f& v );
+    void setTranslation(const ospcommon::vec3f& v);
+    void setLockFirstAnimationFrame(bool st);
+
+    /*! stream the animation timesteps from 'cache' instead of using the
+        models passed to the constructor */
+    void setTimestepCache(std::shared_ptr<timestep_cache> cache);
 
   protected:
 
     virtual void reshape(const ospcommon::vec2i &newSize) override;
     virtual void keypress(char key) override;
+    virtual void mouseButton(int button, int action, int mods) override;
 
     void resetView();
+    bool pickOrbitPivot(const ospcommon::vec2i &pos);
     void printViewport();
     void saveScreenshot(const std::string &basename);
+    void saveFloatScreenshot(const std::string &basename);
     void toggleRenderingPaused();
+
+    void applyQuality(const QualitySettings &quality);
+
+    void toggleCameraPathRecording();
+    void startCameraPathReplay();
+    void stopCameraPathReplay();
+    void advanceCameraPathReplay();
+
+    PerspectiveView currentView() const;
+    const PerspectiveView *viewOf(const RenderedFrame &frame);
     // We override this so we can update the AO ray length
     void setWorldBounds(const ospcommon::box3f &worldBounds) override;
 
@@ -70,8 +94,16 @@ namespace ospray {
 
     virtual void updateAnimation(double deltaSeconds);
 
+    size_t numTimesteps() const;
+    cpp::Model compositeModel(size_t dataFrameId);
+    void releaseCompositeModels();
+    void startPrefetcher();
+    void prefetchAfter(size_t frameId);
+
     virtual void buildGui() override;
 
+    bool needsContinuousRedraw() const override;
+
     // Data //
 
     std::deque<cpp::Model>       sceneModels;
@@ -93,10 +125,66 @@ namespace ospray {
     ospcommon::vec3f translate;
     ospcommon::vec3f scale;
 
+    // NOTE: static scene + transformed timestep, built the first time each
+    //       timestep is shown while lockFirstAnimationFrame is set
+    std::vector<cpp::Model> compositeModels;
+
+    // NOTE: the next few timesteps get built and committed in the background
+    //       while the current one is shown
+    timestep_prefetcher prefetcher;
+    int prefetchTimesteps {2};
+
+    std::shared_ptr<timestep_cache> timesteps;
+
     float aoDistance {1e20f};
 
+    // NOTE: the GUI sets the full quality; while enabled, the governor trades
+    //       it for frame time during interaction
+    QualitySettings  userQuality;
+    QualitySettings  appliedQuality;
+    int              previewLevel {0};
+    bool             governQuality {false};
+    float            targetFps {20.f};
+    quality_governor governor;
+    double           lastInteractionTime {0.0};
+
     async_render_engine renderEngine;
-    std::vector<uint32_t> pixelBuffer;
+    FrameHandle         currentFrame;
+    latency_tracker     latency;
+
+    bool   firstFrameDisplayed {false};
+
+    // basename of a screenshot waiting for a full-resolution frame
+    std::string pendingScreenshot;
+
+    // NOTE: the camera each scheduled generation will render with, so that
+    //       frames can be warped from the view they were rendered with
+    bool reprojectFrames {true};
+    frame_reprojector reprojector;
+    static const size_t MAX_VIEW_HISTORY = 64;
+    std::map<size_t, PerspectiveView> viewHistory;
+    size_t cameraGeneration {0};
+    bool   showingReprojection {false};
+    // what the last warp was made from, it is reused until either changes
+    const std::vector<uint32_t> *warped {nullptr};
+    size_t          warpedFrameId {0};
+    PerspectiveView warpedView;
+
+    int maxAccumFrames {0};
+
+    // NOTE: recording samples the viewport each time it changes; a replay
+    //       moves to the next keyframe once the current one has accumulated
+    //       replayFramesPerKeyframe full-resolution frames
+    camera_path cameraPath;
+    bool   recordingCameraPath {false};
+    double cameraPathStart {0.0};
+    bool   replayingCameraPath {false};
+    int    replayFramesPerKeyframe {1};
+    size_t replayKeyframe {0};
+    bool   replayKeyframeScheduled {false};
+    size_t replayGeneration {0};
+    double replayKeyframeStart {0.0};
+    std::vector<double> replayKeyframeTimes;
   };
 
 }// namespace ospray
@@ -9,7 +9,12 @@
 #include <imgui.h>
 #include "imgui_impl_glfw_gl3.h"
 
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
 // GL3W/GLFW
+#include <GL/gl3w.h>
 #include <GLFW/glfw3.h>
 #ifdef _WIN32
 #undef APIENTRY
@@ -24,12 +29,38 @@ static double       g_Time = 0.0f;
 static bool         g_MousePressed[3] = { false, false, false };
 static float        g_MouseWheel = 0.0f;
 static GLuint       g_FontTexture = 0;
+static GLuint       g_ShaderHandle = 0, g_VertHandle = 0, g_FragHandle = 0;
+static GLint        g_AttribLocationTex = 0, g_AttribLocationProjMtx = 0;
+static GLuint       g_VaoHandle = 0, g_VboHandle = 0, g_ElementsHandle = 0;
+static GLsizeiptr   g_VboCapacity = 0, g_ElementsCapacity = 0;
+static bool         g_DeviceObjectsCreated = false;
+
+// Fixed-function renderer for pre-3.0 contexts (imgui_impl_glfw_gl2.cpp)
+void ImGui_ImplGlfwGL2_RenderDrawLists(ImDrawData* draw_data);
+
+// Grow a streaming buffer geometrically, so a GUI that gets bigger for a few
+// frames doesn't reallocate it every frame
+static void ImGui_ImplGlfwGL3_ReserveBuffer(GLenum target, GLsizeiptr& capacity, GLsizeiptr size)
+{
+    if (size > capacity)
+        capacity = size + size / 2;
+
+    // NOTE: orphan the previous storage, the driver hands us fresh memory
+    //       instead of waiting for last frame's draws to finish reading it
+    glBufferData(target, capacity, NULL, GL_STREAM_DRAW);
+}
 
 // This is the main rendering function that you have to implement and provide to ImGui (via setting up 'RenderDrawListsFn' in the ImGuiIO structure)
-// If text or lines are blurry when integrating ImGui in your engine:
-// - in your Render function, try translating your projection matrix by (0.5f,0.5f) or (0.375f,0.375f)
+// All command lists are uploaded with one buffer write each for vertices and
+// indices, then drawn from a single VAO.
 void ImGui_ImplGlfwGL3_RenderDrawLists(ImDrawData* draw_data)
 {
+    if (!g_ShaderHandle)
+    {
+        ImGui_ImplGlfwGL2_RenderDrawLists(draw_data);
+        return;
+    }
+
     // Avoid rendering when minimized, scale coordinates for retina displays (screen coordinates != framebuffer coordinates)
     ImGuiIO& io = ImGui::GetIO();
     int fb_width = (int)(io.DisplaySize.x * io.DisplayFramebufferScale.x);
@@ -38,43 +69,93 @@ void ImGui_ImplGlfwGL3_RenderDrawLists(ImDrawData* draw_data)
         return;
     draw_data->ScaleClipRects(io.DisplayFramebufferScale);
 
-    // We are using the OpenGL fixed pipeline to make the example code simpler to read!
-    // Setup render state: alpha-blending enabled, no face culling, no depth testing, scissor enabled, vertex/texcoord/color pointers.
+    if (draw_data->TotalVtxCount == 0 || draw_data->TotalIdxCount == 0)
+        return;
+
+    // Backup GL state
+    GLint last_program; glGetIntegerv(GL_CURRENT_PROGRAM, &last_program);
+    GLint last_active_texture; glGetIntegerv(GL_ACTIVE_TEXTURE, &last_active_texture);
+    glActiveTexture(GL_TEXTURE0);
     GLint last_texture; glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
+    GLint last_array_buffer; glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &last_array_buffer);
+    GLint last_vertex_array; glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &last_vertex_array);
+    GLint last_blend_src; glGetIntegerv(GL_BLEND_SRC_RGB, &last_blend_src);
+    GLint last_blend_dst; glGetIntegerv(GL_BLEND_DST_RGB, &last_blend_dst);
+    GLint last_blend_src_alpha; glGetIntegerv(GL_BLEND_SRC_ALPHA, &last_blend_src_alpha);
+    GLint last_blend_dst_alpha; glGetIntegerv(GL_BLEND_DST_ALPHA, &last_blend_dst_alpha);
+    GLint last_blend_equation_rgb; glGetIntegerv(GL_BLEND_EQUATION_RGB, &last_blend_equation_rgb);
+    GLint last_blend_equation_alpha; glGetIntegerv(GL_BLEND_EQUATION_ALPHA, &last_blend_equation_alpha);
     GLint last_viewport[4]; glGetIntegerv(GL_VIEWPORT, last_viewport);
     GLint last_scissor_box[4]; glGetIntegerv(GL_SCISSOR_BOX, last_scissor_box);
-    glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_TRANSFORM_BIT);
+    GLboolean last_enable_blend = glIsEnabled(GL_BLEND);
+    GLboolean last_enable_cull_face = glIsEnabled(GL_CULL_FACE);
+    GLboolean last_enable_depth_test = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean last_enable_scissor_test = glIsEnabled(GL_SCISSOR_TEST);
+
+    // Setup render state: alpha-blending enabled, no face culling, no depth testing, scissor enabled
     glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glDisable(GL_CULL_FACE);
     glDisable(GL_DEPTH_TEST);
     glEnable(GL_SCISSOR_TEST);
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-    glEnableClientState(GL_COLOR_ARRAY);
-    glEnable(GL_TEXTURE_2D);
-    //glUseProgram(0); // You may want this if using this code in an OpenGL 3+ context
 
     // Setup viewport, orthographic projection matrix
     glViewport(0, 0, (GLsizei)fb_width, (GLsizei)fb_height);
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadIdentity();
-    glOrtho(0.0f, io.DisplaySize.x, io.DisplaySize.y, 0.0f, -1.0f, +1.0f);
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
+    const float ortho_projection[4][4] =
+    {
+        { 2.0f/io.DisplaySize.x, 0.0f,                   0.0f, 0.0f },
+        { 0.0f,                  2.0f/-io.DisplaySize.y, 0.0f, 0.0f },
+        { 0.0f,                  0.0f,                  -1.0f, 0.0f },
+        {-1.0f,                  1.0f,                   0.0f, 1.0f },
+    };
+    glUseProgram(g_ShaderHandle);
+    glUniform1i(g_AttribLocationTex, 0);
+    glUniformMatrix4fv(g_AttribLocationProjMtx, 1, GL_FALSE, &ortho_projection[0][0]);
+    glBindVertexArray(g_VaoHandle);
+
+    // Upload all command lists at once. Indices get rebased onto the
+    // combined vertex buffer, so they are widened to 32 bits on the way
+    const GLsizeiptr vtx_size = (GLsizeiptr)draw_data->TotalVtxCount * sizeof(ImDrawVert);
+    const GLsizeiptr idx_size = (GLsizeiptr)draw_data->TotalIdxCount * sizeof(GLuint);
+
+    glBindBuffer(GL_ARRAY_BUFFER, g_VboHandle);
+    ImGui_ImplGlfwGL3_ReserveBuffer(GL_ARRAY_BUFFER, g_VboCapacity, vtx_size);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_ElementsHandle);
+    ImGui_ImplGlfwGL3_ReserveBuffer(GL_ELEMENT_ARRAY_BUFFER, g_ElementsCapacity, idx_size);
+
+    const GLbitfield map_flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    ImDrawVert* vtx_dst = (ImDrawVert*)glMapBufferRange(GL_ARRAY_BUFFER, 0, vtx_size, map_flags);
+    GLuint* idx_dst = (GLuint*)glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, idx_size, map_flags);
+
+    if (vtx_dst && idx_dst)
+    {
+        GLuint vtx_offset = 0;
+        for (int n = 0; n < draw_data->CmdListsCount; n++)
+        {
+            const ImDrawList* cmd_list = draw_data->CmdLists[n];
+            memcpy(vtx_dst, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+            vtx_dst += cmd_list->VtxBuffer.Size;
+
+            for (int i = 0; i < cmd_list->IdxBuffer.Size; i++)
+                idx_dst[i] = vtx_offset + cmd_list->IdxBuffer.Data[i];
+            idx_dst += cmd_list->IdxBuffer.Size;
+
+            vtx_offset += cmd_list->VtxBuffer.Size;
+        }
+    }
+
+    const bool uploaded = (vtx_dst != NULL) & (idx_dst != NULL);
+    if (vtx_dst)
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    if (idx_dst)
+        glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
 
     // Render command lists
-    #define OFFSETOF(TYPE, ELEMENT) ((size_t)&(((TYPE *)0)->ELEMENT))
-    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    size_t idx_offset = 0;
+    for (int n = 0; uploaded && n < draw_data->CmdListsCount; n++)
     {
         const ImDrawList* cmd_list = draw_data->CmdLists[n];
-        const ImDrawVert* vtx_buffer = cmd_list->VtxBuffer.Data;
-        const ImDrawIdx* idx_buffer = cmd_list->IdxBuffer.Data;
-        glVertexPointer(2, GL_FLOAT, sizeof(ImDrawVert), (const GLvoid*)((const char*)vtx_buffer + OFFSETOF(ImDrawVert, pos)));
-        glTexCoordPointer(2, GL_FLOAT, sizeof(ImDrawVert), (const GLvoid*)((const char*)vtx_buffer + OFFSETOF(ImDrawVert, uv)));
-        glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(ImDrawVert), (const GLvoid*)((const char*)vtx_buffer + OFFSETOF(ImDrawVert, col)));
 
         for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
         {
@@ -87,26 +168,26 @@ void ImGui_ImplGlfwGL3_RenderDrawLists(ImDrawData* draw_data)
             {
                 glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)pcmd->TextureId);
                 glScissor((int)pcmd->ClipRect.x, (int)(fb_height - pcmd->ClipRect.w), (int)(pcmd->ClipRect.z - pcmd->ClipRect.x), (int)(pcmd->ClipRect.w - pcmd->ClipRect.y));
-                glDrawElements(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, idx_buffer);
+                glDrawElements(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, GL_UNSIGNED_INT, (const GLvoid*)(idx_offset * sizeof(GLuint)));
             }
-            idx_buffer += pcmd->ElemCount;
+            idx_offset += pcmd->ElemCount;
         }
     }
-    #undef OFFSETOF
-
-    // Restore modified state
-    glDisableClientState(GL_COLOR_ARRAY);
-    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-    glDisableClientState(GL_VERTEX_ARRAY);
-    glBindTexture(GL_TEXTURE_2D, (GLuint)last_texture);
-    glMatrixMode(GL_MODELVIEW);
-    glPopMatrix();
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
-    glPopAttrib();
+
+    // Restore modified GL state
+    glUseProgram(last_program);
+    glBindTexture(GL_TEXTURE_2D, last_texture);
+    glActiveTexture(last_active_texture);
+    glBindVertexArray(last_vertex_array);
+    glBindBuffer(GL_ARRAY_BUFFER, last_array_buffer);
+    glBlendEquationSeparate(last_blend_equation_rgb, last_blend_equation_alpha);
+    glBlendFuncSeparate(last_blend_src, last_blend_dst, last_blend_src_alpha, last_blend_dst_alpha);
+    if (last_enable_blend) glEnable(GL_BLEND); else glDisable(GL_BLEND);
+    if (last_enable_cull_face) glEnable(GL_CULL_FACE); else glDisable(GL_CULL_FACE);
+    if (last_enable_depth_test) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
+    if (last_enable_scissor_test) glEnable(GL_SCISSOR_TEST); else glDisable(GL_SCISSOR_TEST);
     glViewport(last_viewport[0], last_viewport[1], (GLsizei)last_viewport[2], (GLsizei)last_viewport[3]);
-    glScissor(last_scissor_box[0], last_scissor_box[1],
-(GLsizei)last_scissor_box[2], (GLsizei)last_scissor_box[3]);
+    glScissor(last_scissor_box[0], last_scissor_box[1], (GLsizei)last_scissor_box[2], (GLsizei)last_scissor_box[3]);
 }
 
 static const char* ImGui_ImplGlfwGL3_GetClipboardText(void* user_data)
@@ -171,40 +252,162 @@ bool ImGui_ImplGlfwGL3_CreateFontsTexture()
     return true;
 }
 
-bool ImGui_ImplGlfwGL3_CreateDeviceObjects()
+static bool ImGui_ImplGlfwGL3_CheckShader(GLuint handle, const char* desc)
 {
-    // Build texture atlas
-    ImGuiIO& io = ImGui::GetIO();
-    unsigned char* pixels;
-    int width, height;
-    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);   // Load as RGBA 32-bits (75% of the memory is wasted, but default font is so small) because it is more likely to be compatible with user's existing shaders. If your ImTextureId represent a higher-level concept than just a GL texture id, consider calling GetTexDataAsAlpha8() instead to save on GPU memory.
-
-    // Upload texture to graphics system
-    GLint last_texture;
-    glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
-    glGenTextures(1, &g_FontTexture);
-    glBindTexture(GL_TEXTURE_2D, g_FontTexture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    GLint status = 0;
+    glGetShaderiv(handle, GL_COMPILE_STATUS, &status);
+    if (status == GL_FALSE)
+    {
+        char log[1024];
+        glGetShaderInfoLog(handle, sizeof(log), NULL, log);
+        fprintf(stderr, "ImGui: failed to compile %s shader: %s\n", desc, log);
+    }
+    return status == GL_TRUE;
+}
 
-    // Store our identifier
-    io.Fonts->TexID = (void *)(intptr_t)g_FontTexture;
+static bool ImGui_ImplGlfwGL3_CreateShaderObjects()
+{
+    // NOTE: the window asks GLFW for a 2.0 context, so which path runs is up
+    //       to the driver: Mesa, NVIDIA and AMD hand out a 3.0+
+    //       compatibility context, which takes this one. macOS hands out a
+    //       2.1 context and keeps the fixed-function renderer. That is just
+    //       as well, since macOS core contexts reject '#version 130'. If
+    //       the shaders fail to compile, we fall back as well.
+    const GLchar* vertex_shader =
+        "#version 130\n"
+        "uniform mat4 ProjMtx;\n"
+        "in vec2 Position;\n"
+        "in vec2 UV;\n"
+        "in vec4 Color;\n"
+        "out vec2 Frag_UV;\n"
+        "out vec4 Frag_Color;\n"
+        "void main()\n"
+        "{\n"
+        "    Frag_UV = UV;\n"
+        "    Frag_Color = Color;\n"
+        "    gl_Position = ProjMtx * vec4(Position.xy,0,1);\n"
+        "}\n";
+
+    const GLchar* fragment_shader =
+        "#version 130\n"
+        "uniform sampler2D Texture;\n"
+        "in vec2 Frag_UV;\n"
+        "in vec4 Frag_Color;\n"
+        "out vec4 Out_Color;\n"
+        "void main()\n"
+        "{\n"
+        "    Out_Color = Frag_Color * texture(Texture, Frag_UV.st);\n"
+        "}\n";
+
+    g_VertHandle = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(g_VertHandle, 1, &vertex_shader, NULL);
+    glCompileShader(g_VertHandle);
+
+    g_FragHandle = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(g_FragHandle, 1, &fragment_shader, NULL);
+    glCompileShader(g_FragHandle);
+
+    if (!ImGui_ImplGlfwGL3_CheckShader(g_VertHandle, "vertex") ||
+        !ImGui_ImplGlfwGL3_CheckShader(g_FragHandle, "fragment"))
+        return false;
+
+    g_ShaderHandle = glCreateProgram();
+    glAttachShader(g_ShaderHandle, g_VertHandle);
+    glAttachShader(g_ShaderHandle, g_FragHandle);
+    glBindAttribLocation(g_ShaderHandle, 0, "Position");
+    glBindAttribLocation(g_ShaderHandle, 1, "UV");
+    glBindAttribLocation(g_ShaderHandle, 2, "Color");
+    glBindFragDataLocation(g_ShaderHandle, 0, "Out_Color");
+    glLinkProgram(g_ShaderHandle);
+
+    GLint status = 0;
+    glGetProgramiv(g_ShaderHandle, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE)
+    {
+        fprintf(stderr, "ImGui: failed to link the GUI shader program\n");
+        glDeleteProgram(g_ShaderHandle);
+        g_ShaderHandle = 0;
+        return false;
+    }
 
-    // Restore state
-    glBindTexture(GL_TEXTURE_2D, last_texture);
+    g_AttribLocationTex = glGetUniformLocation(g_ShaderHandle, "Texture");
+    g_AttribLocationProjMtx = glGetUniformLocation(g_ShaderHandle, "ProjMtx");
 
     return true;
 }
 
+static void ImGui_ImplGlfwGL3_CreateBufferObjects()
+{
+    GLint last_array_buffer; glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &last_array_buffer);
+    GLint last_vertex_array; glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &last_vertex_array);
+
+    glGenBuffers(1, &g_VboHandle);
+    glGenBuffers(1, &g_ElementsHandle);
+    g_VboCapacity = g_ElementsCapacity = 0;
+
+    // NOTE: the element buffer binding is VAO state, so it stays bound here
+    glGenVertexArrays(1, &g_VaoHandle);
+    glBindVertexArray(g_VaoHandle);
+    glBindBuffer(GL_ARRAY_BUFFER, g_VboHandle);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_ElementsHandle);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+
+#define OFFSETOF(TYPE, ELEMENT) ((size_t)&(((TYPE *)0)->ELEMENT))
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid*)OFFSETOF(ImDrawVert, pos));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid*)OFFSETOF(ImDrawVert, uv));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (GLvoid*)OFFSETOF(ImDrawVert, col));
+#undef OFFSETOF
+
+    glBindVertexArray(last_vertex_array);
+    glBindBuffer(GL_ARRAY_BUFFER, last_array_buffer);
+}
+
+bool ImGui_ImplGlfwGL3_CreateDeviceObjects()
+{
+    g_DeviceObjectsCreated = true;
+
+    // NOTE: without GL 3.0 the GUI is drawn by the fixed-function renderer,
+    //       which only needs the font texture
+    if (gl3wIsSupported(3, 0))
+    {
+        if (ImGui_ImplGlfwGL3_CreateShaderObjects())
+            ImGui_ImplGlfwGL3_CreateBufferObjects();
+        else
+            fprintf(stderr, "ImGui: falling back to fixed-function rendering\n");
+    }
+
+    return ImGui_ImplGlfwGL3_CreateFontsTexture();
+}
+
 void ImGui_ImplGlfwGL3_InvalidateDeviceObjects()
 {
+    if (g_VaoHandle) glDeleteVertexArrays(1, &g_VaoHandle);
+    if (g_VboHandle) glDeleteBuffers(1, &g_VboHandle);
+    if (g_ElementsHandle) glDeleteBuffers(1, &g_ElementsHandle);
+    g_VaoHandle = g_VboHandle = g_ElementsHandle = 0;
+    g_VboCapacity = g_ElementsCapacity = 0;
+
+    if (g_ShaderHandle && g_VertHandle) glDetachShader(g_ShaderHandle, g_VertHandle);
+    if (g_VertHandle) glDeleteShader(g_VertHandle);
+    g_VertHandle = 0;
+
+    if (g_ShaderHandle && g_FragHandle) glDetachShader(g_ShaderHandle, g_FragHandle);
+    if (g_FragHandle) glDeleteShader(g_FragHandle);
+    g_FragHandle = 0;
+
+    if (g_ShaderHandle) glDeleteProgram(g_ShaderHandle);
+    g_ShaderHandle = 0;
+
     if (g_FontTexture)
     {
         glDeleteTextures(1, &g_FontTexture);
         ImGui::GetIO().Fonts->TexID = 0;
         g_FontTexture = 0;
     }
+
+    g_DeviceObjectsCreated = false;
 }
 
 bool ImGui_ImplGlfwGL3_Init(GLFWwindow* window, bool install_callbacks)
@@ -261,7 +464,7 @@ void ImGui_ImplGlfwGL3_Shutdown()
 
 void ImGui_ImplGlfwGL3_NewFrame()
 {
-    if (!g_FontTexture)
+    if (!g_DeviceObjectsCreated)
       ImGui_ImplGlfwGL3_CreateDeviceObjects();
 
     ImGuiIO& io = ImGui::GetIO();